@@ -0,0 +1,255 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <benchmark/benchmark.h>
+
+#include "owned_pointer.hpp"
+
+namespace
+{
+
+struct base
+{
+  int x = 0;
+  virtual ~base() = default;
+};
+
+struct derived : base {};
+
+constexpr int max_threads = 8;
+
+// Handles shared by all threads of benchmark, reference counts are contended.
+auto shared_owned() -> const csp::owned_pointer<derived>&
+{
+  static const auto p = csp::make_owned<derived>();
+  return p;
+}
+
+auto shared_owned_base() -> const csp::owned_pointer<base>&
+{
+  static const csp::owned_pointer<base> p = shared_owned();
+  return p;
+}
+
+auto shared_shared() -> const std::shared_ptr<derived>&
+{
+  static const auto p = std::make_shared<derived>();
+  return p;
+}
+
+auto shared_shared_base() -> const std::shared_ptr<base>&
+{
+  static const std::shared_ptr<base> p = shared_shared();
+  return p;
+}
+
+/*****************************************************************************************
+ *
+ * Creation, baselines first
+ *
+ *****************************************************************************************/
+
+void make_unique_baseline(benchmark::State& state)
+{
+  for(auto _ : state)
+    benchmark::DoNotOptimize(std::unique_ptr<base>{new derived});
+}
+
+void make_shared_baseline(benchmark::State& state)
+{
+  for(auto _ : state)
+    benchmark::DoNotOptimize(std::make_shared<derived>());
+}
+
+void make_owned(benchmark::State& state)
+{
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::make_owned<derived>());
+}
+
+void make_owned_not_expired_enabled(benchmark::State& state)
+{
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::make_owned<int>(1));
+}
+
+void make_owned_and_unique_ptr(benchmark::State& state)
+{
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::make_owned<derived>().unique_ptr());
+}
+
+/*****************************************************************************************
+ *
+ * Copies
+ *
+ *****************************************************************************************/
+
+void copy_shared_baseline(benchmark::State& state)
+{
+  const auto& p = shared_shared();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(std::shared_ptr<derived>{p});
+}
+
+void copy_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::owned_pointer<derived>{p});
+}
+
+/*****************************************************************************************
+ *
+ * Access
+ *
+ *****************************************************************************************/
+
+void arrow_unique_baseline(benchmark::State& state)
+{
+  const std::unique_ptr<base> u{new derived};
+  for(auto _ : state)
+    benchmark::DoNotOptimize(u->x);
+}
+
+void arrow_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p->x);
+}
+
+void get_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p.get());
+}
+
+// get() of class type checks if object is lazy, it is one more load of control block
+void get_owned_not_class(benchmark::State& state)
+{
+  static const auto p = csp::make_owned<int>(1);
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p.get());
+}
+
+void get_owned_lazy(benchmark::State& state)
+{
+  static const auto p = csp::make_owned_lazy<derived>();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p.get());
+}
+
+void get_nothrow_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p.get(std::nothrow));
+}
+
+void expired_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p.expired());
+}
+
+void compare_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  const auto raw = p.get();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(p == raw);
+}
+
+/*****************************************************************************************
+ *
+ * Casts and links
+ *
+ *****************************************************************************************/
+
+void static_pointer_cast_shared_baseline(benchmark::State& state)
+{
+  const auto& p = shared_shared();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(std::static_pointer_cast<base>(p));
+}
+
+void static_pointer_cast_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::static_pointer_cast<base>(p));
+}
+
+void dynamic_pointer_cast_shared_baseline(benchmark::State& state)
+{
+  const auto& p = shared_shared_base();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(std::dynamic_pointer_cast<derived>(p));
+}
+
+void dynamic_pointer_cast_owned(benchmark::State& state)
+{
+  const auto& p = shared_owned_base();
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::dynamic_pointer_cast<derived>(p));
+}
+
+void link_owned(benchmark::State& state)
+{
+  auto p = csp::make_owned<derived>();
+  const auto u = p.unique_ptr();
+
+  for(auto _ : state)
+    benchmark::DoNotOptimize(csp::owned_pointer<derived>{csp::link(u)});
+}
+
+} // namespace
+
+BENCHMARK(make_unique_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(make_shared_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(make_owned)->ThreadRange(1, max_threads);
+BENCHMARK(make_owned_not_expired_enabled)->ThreadRange(1, max_threads);
+BENCHMARK(make_owned_and_unique_ptr)->ThreadRange(1, max_threads);
+
+BENCHMARK(copy_shared_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(copy_owned)->ThreadRange(1, max_threads);
+
+BENCHMARK(arrow_unique_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(arrow_owned)->ThreadRange(1, max_threads);
+BENCHMARK(get_owned)->ThreadRange(1, max_threads);
+BENCHMARK(get_owned_not_class)->ThreadRange(1, max_threads);
+BENCHMARK(get_owned_lazy)->ThreadRange(1, max_threads);
+BENCHMARK(get_nothrow_owned)->ThreadRange(1, max_threads);
+BENCHMARK(expired_owned)->ThreadRange(1, max_threads);
+BENCHMARK(compare_owned)->ThreadRange(1, max_threads);
+
+BENCHMARK(static_pointer_cast_shared_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(static_pointer_cast_owned)->ThreadRange(1, max_threads);
+BENCHMARK(dynamic_pointer_cast_shared_baseline)->ThreadRange(1, max_threads);
+BENCHMARK(dynamic_pointer_cast_owned)->ThreadRange(1, max_threads);
+BENCHMARK(link_owned)->ThreadRange(1, max_threads);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,268 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include "gmock_macros_for_unique_ptr.hpp"
+
+// Calls per second through MOCK_UNIQUE_METHODn and MOCK_UNIQUE_CONST_METHODn thunks,
+// next to plain MOCK_METHODn taking and returning raw pointers. Both sides allocate
+// and delete the same objects, so the difference is cost of _forward, of owned_pointer
+// parameters and of static_cast of returned owned_pointer to std::unique_ptr.
+
+namespace
+{
+
+struct object
+{
+  virtual ~object() = default;
+};
+
+using uptr = std::unique_ptr<object>;
+
+struct unique_interface
+{
+  virtual ~unique_interface() = default;
+
+  virtual uptr call0() = 0;
+  virtual uptr call1(uptr) = 0;
+  virtual uptr call2(uptr, uptr) = 0;
+  virtual uptr call3(uptr, uptr, uptr) = 0;
+  virtual uptr call4(uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call5(uptr, uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call6(uptr, uptr, uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call7(uptr, uptr, uptr, uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call8(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call9(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) = 0;
+  virtual uptr call10(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) = 0;
+
+  virtual uptr const_call0() const = 0;
+  virtual uptr const_call1(uptr) const = 0;
+  virtual uptr const_call2(uptr, uptr) const = 0;
+  virtual uptr const_call3(uptr, uptr, uptr) const = 0;
+  virtual uptr const_call4(uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call5(uptr, uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call6(uptr, uptr, uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call7(uptr, uptr, uptr, uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call8(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call9(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) const = 0;
+  virtual uptr const_call10(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr) const = 0;
+};
+
+struct raw_interface
+{
+  virtual ~raw_interface() = default;
+
+  virtual object* call0() = 0;
+  virtual object* call1(object*) = 0;
+  virtual object* call2(object*, object*) = 0;
+  virtual object* call3(object*, object*, object*) = 0;
+  virtual object* call4(object*, object*, object*, object*) = 0;
+  virtual object* call5(object*, object*, object*, object*, object*) = 0;
+  virtual object* call6(object*, object*, object*, object*, object*, object*) = 0;
+  virtual object* call7(object*, object*, object*, object*, object*, object*, object*) = 0;
+  virtual object* call8(object*, object*, object*, object*, object*, object*, object*, object*) = 0;
+  virtual object* call9(object*, object*, object*, object*, object*, object*, object*, object*, object*) = 0;
+  virtual object* call10(object*, object*, object*, object*, object*, object*, object*, object*, object*, object*) = 0;
+};
+
+struct unique_mock : unique_interface
+{
+  MOCK_UNIQUE_METHOD0(call0, uptr());
+  MOCK_UNIQUE_METHOD1(call1, uptr(uptr));
+  MOCK_UNIQUE_METHOD2(call2, uptr(uptr, uptr));
+  MOCK_UNIQUE_METHOD3(call3, uptr(uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD4(call4, uptr(uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD5(call5, uptr(uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD6(call6, uptr(uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD7(call7, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD8(call8, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD9(call9, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_METHOD10(call10, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+
+  MOCK_UNIQUE_CONST_METHOD0(const_call0, uptr());
+  MOCK_UNIQUE_CONST_METHOD1(const_call1, uptr(uptr));
+  MOCK_UNIQUE_CONST_METHOD2(const_call2, uptr(uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD3(const_call3, uptr(uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD4(const_call4, uptr(uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD5(const_call5, uptr(uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD6(const_call6, uptr(uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD7(const_call7, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD8(const_call8, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD9(const_call9, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+  MOCK_UNIQUE_CONST_METHOD10(const_call10, uptr(uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr, uptr));
+};
+
+struct raw_mock : raw_interface
+{
+  MOCK_METHOD0(call0, object*());
+  MOCK_METHOD1(call1, object*(object*));
+  MOCK_METHOD2(call2, object*(object*, object*));
+  MOCK_METHOD3(call3, object*(object*, object*, object*));
+  MOCK_METHOD4(call4, object*(object*, object*, object*, object*));
+  MOCK_METHOD5(call5, object*(object*, object*, object*, object*, object*));
+  MOCK_METHOD6(call6, object*(object*, object*, object*, object*, object*, object*));
+  MOCK_METHOD7(call7, object*(object*, object*, object*, object*, object*, object*, object*));
+  MOCK_METHOD8(call8, object*(object*, object*, object*, object*, object*, object*, object*, object*));
+  MOCK_METHOD9(call9, object*(object*, object*, object*, object*, object*, object*, object*, object*, object*));
+  MOCK_METHOD10(call10, object*(object*, object*, object*, object*, object*, object*, object*, object*, object*, object*));
+};
+
+constexpr int max_threads = 8;
+
+template<std::size_t> using uptr_arg = uptr;
+template<std::size_t> using raw_arg = object*;
+template<std::size_t> auto make_arg() -> object* { return new object; }
+
+/*****************************************************************************************
+ *
+ * Methods of given arity and their default actions
+ *
+ *****************************************************************************************/
+
+template<std::size_t N>
+struct methods;
+
+#define OWNED_POINTER_BENCH_METHODS(n, ...) \
+template<>\
+struct methods<n>\
+{\
+  static auto unique() -> decltype(&unique_interface::call ## n) { return &unique_interface::call ## n; }\
+  static auto unique_const() -> decltype(&unique_interface::const_call ## n) { return &unique_interface::const_call ## n; }\
+  static auto raw() -> decltype(&raw_interface::call ## n) { return &raw_interface::call ## n; }\
+\
+  static void set_defaults(unique_mock& m)\
+  {\
+    using ::testing::_;\
+    ON_CALL(m, _call ## n(__VA_ARGS__)).WillByDefault(::testing::InvokeWithoutArgs(&make_result));\
+    ON_CALL(m, _const_call ## n(__VA_ARGS__)).WillByDefault(::testing::InvokeWithoutArgs(&make_result));\
+  }\
+\
+  static void set_defaults(raw_mock& m)\
+  {\
+    using ::testing::_;\
+    ON_CALL(m, call ## n(__VA_ARGS__)).WillByDefault(::testing::InvokeWithoutArgs(&make_arg<0>));\
+  }\
+\
+  static auto make_result() -> csp::owned_pointer<object> { return csp::make_owned<object>(); }\
+}
+
+OWNED_POINTER_BENCH_METHODS(0, );
+OWNED_POINTER_BENCH_METHODS(1, _);
+OWNED_POINTER_BENCH_METHODS(2, _, _);
+OWNED_POINTER_BENCH_METHODS(3, _, _, _);
+OWNED_POINTER_BENCH_METHODS(4, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(5, _, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(6, _, _, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(7, _, _, _, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(8, _, _, _, _, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(9, _, _, _, _, _, _, _, _, _);
+OWNED_POINTER_BENCH_METHODS(10, _, _, _, _, _, _, _, _, _, _);
+
+#undef OWNED_POINTER_BENCH_METHODS
+
+template<typename F, std::size_t... A>
+auto call(unique_interface& m, F f, std::index_sequence<A...>) -> uptr
+{
+  return (m.*f)(uptr_arg<A>{make_arg<A>()}...);
+}
+
+template<std::size_t... A>
+auto call(raw_interface& m, object* (raw_interface::*f)(raw_arg<A>...), std::index_sequence<A...>) -> object*
+{
+  object* const args[] = {nullptr, make_arg<A>()...};
+  const auto result = (m.*f)(args[A + 1]...);
+
+  for(const auto a : args)
+    delete a;
+
+  return result;
+}
+
+/*****************************************************************************************
+ *
+ * Dispatch, every thread calls its own mock, so only gmock's global mutex is shared
+ *
+ *****************************************************************************************/
+
+template<std::size_t N>
+void mock_method_baseline(benchmark::State& state)
+{
+  ::testing::NiceMock<raw_mock> mock;
+  methods<N>::set_defaults(mock);
+
+  for(auto _ : state)
+  {
+    const auto result = call(mock, methods<N>::raw(), std::make_index_sequence<N>{});
+    benchmark::DoNotOptimize(result);
+    delete result;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+template<std::size_t N>
+void mock_unique_method(benchmark::State& state)
+{
+  ::testing::NiceMock<unique_mock> mock;
+  methods<N>::set_defaults(mock);
+
+  for(auto _ : state)
+    benchmark::DoNotOptimize(call(mock, methods<N>::unique(), std::make_index_sequence<N>{}));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+template<std::size_t N>
+void mock_unique_const_method(benchmark::State& state)
+{
+  ::testing::NiceMock<unique_mock> mock;
+  methods<N>::set_defaults(mock);
+
+  for(auto _ : state)
+    benchmark::DoNotOptimize(call(mock, methods<N>::unique_const(), std::make_index_sequence<N>{}));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+#define OWNED_POINTER_BENCH_DISPATCH(n) \
+  BENCHMARK_TEMPLATE(mock_method_baseline, n)->ThreadRange(1, max_threads); \
+  BENCHMARK_TEMPLATE(mock_unique_method, n)->ThreadRange(1, max_threads); \
+  BENCHMARK_TEMPLATE(mock_unique_const_method, n)->ThreadRange(1, max_threads)
+
+OWNED_POINTER_BENCH_DISPATCH(0);
+OWNED_POINTER_BENCH_DISPATCH(1);
+OWNED_POINTER_BENCH_DISPATCH(2);
+OWNED_POINTER_BENCH_DISPATCH(3);
+OWNED_POINTER_BENCH_DISPATCH(4);
+OWNED_POINTER_BENCH_DISPATCH(5);
+OWNED_POINTER_BENCH_DISPATCH(6);
+OWNED_POINTER_BENCH_DISPATCH(7);
+OWNED_POINTER_BENCH_DISPATCH(8);
+OWNED_POINTER_BENCH_DISPATCH(9);
+OWNED_POINTER_BENCH_DISPATCH(10);
+
+BENCHMARK_MAIN();
@@ -16,9 +16,7 @@ int main()
   using namespace ::csp;
 
   std::vector<unique_ptr<Foo>> u;
-  std::vector<owned_pointer<Foo>> v(15, nullptr);
-
-  std::generate(v.begin(), v.end(), [](){ return make_owned<Foo>(); });
+  std::vector<owned_pointer<Foo>> v = make_owned_n<Foo>(15);
   std::cout << "---------------------------\n";
 
   for(auto& e : v)
@@ -0,0 +1,745 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <typeinfo>
+#include <type_traits>
+#include "owned_pointer.hpp"
+
+namespace csp
+{
+
+namespace _priv
+{
+
+struct single_thread_count
+{
+  using value_type = long;
+
+  static void increment(value_type& c) noexcept { ++c; }
+  static bool decrement(value_type& c) noexcept { return --c == 0; }
+  static long load(const value_type& c) noexcept { return c; }
+};
+
+struct atomic_count
+{
+  using value_type = std::atomic<long>;
+
+  static void increment(value_type& c) noexcept { c.fetch_add(1, std::memory_order_relaxed); }
+  static bool decrement(value_type& c) noexcept { return c.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+  static long load(const value_type& c) noexcept { return c.load(std::memory_order_relaxed); }
+};
+
+template<typename Count>
+struct intrusive_block
+{
+  using count_type = typename Count::value_type;
+
+  intrusive_block(void *const p, const bool a,
+                  void (*const d)(intrusive_block*), void (*const f)(intrusive_block*)) noexcept
+    : object{p}, acquired{a}, dispose{d}, destroy{f} {}
+
+  count_type uses{1};
+  count_type pins{1}; // one for all handles and one for living embedded object
+  void* object;
+  state_flag acquired;
+  state_flag deleted{false};
+  void (*const dispose)(intrusive_block*);
+  void (*const destroy)(intrusive_block*);
+};
+
+template<typename Count>
+inline void unpin(intrusive_block<Count> *const b) noexcept
+{
+  if(Count::decrement(b->pins))
+    b->destroy(b);
+}
+
+template<typename Count>
+inline void add_ref(intrusive_block<Count> *const b) noexcept
+{
+  if(b) Count::increment(b->uses);
+}
+
+template<typename Count>
+inline void release(intrusive_block<Count> *const b)
+{
+  if(!b || !Count::decrement(b->uses))
+    return;
+
+#ifdef OWNED_POINTER_ASSERT_DTOR
+  assert(b->acquired.load() && "ASSERT: you created owned_pointer, but unique_ptr was never acquired");
+#else
+  if(!b->acquired.load())
+    b->dispose(b);
+#endif
+  unpin(b);
+}
+
+template<typename T, typename Count>
+struct intrusive_separate_block
+{
+  static auto create(T *const p, const bool acquired) -> intrusive_block<Count>*
+  {
+    return new intrusive_block<Count>{p, acquired, &dispose, &destroy};
+  }
+
+  static void dispose(intrusive_block<Count> *const b) { delete static_cast<T*>(b->object); }
+  static void destroy(intrusive_block<Count> *const b) { delete b; }
+};
+
+// Costs one vptr in object, pointer to any its base finds block by dynamic_cast
+template<typename Count>
+class intrusive_secret
+{
+public:
+  virtual auto intrusive_header() noexcept -> intrusive_block<Count>& = 0;
+
+protected:
+  ~intrusive_secret() = default;
+};
+
+template<typename Base, typename Count>
+struct intrusive_object : Base, intrusive_secret<Count>
+{
+  static_assert(is_embeddable<Base>::value, "intrusive_object needs non final base with virtual destructor");
+
+  using Base::Base;
+  ~intrusive_object() override;
+
+  auto intrusive_header() noexcept -> intrusive_block<Count>& override;
+
+  // Memory belongs to block, which is released once object is gone.
+  static void operator delete(void *const p) noexcept;
+};
+
+// Over-aligned block is allocated with aligned new of C++17, without it alignment
+// can't exceed the one of plain new
+template<typename Block>
+inline auto allocate_block() -> void*
+{
+#ifdef __cpp_aligned_new
+  if(alignof(Block) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    return ::operator new(sizeof(Block), static_cast<std::align_val_t>(alignof(Block)));
+#else
+  static_assert(alignof(Block) <= alignof(std::max_align_t), "over-aligned object needs C++17 aligned new");
+#endif
+  return ::operator new(sizeof(Block));
+}
+
+template<typename Block>
+inline void deallocate_block(void *const p) noexcept
+{
+#ifdef __cpp_aligned_new
+  if(alignof(Block) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+  {
+    ::operator delete(p, static_cast<std::align_val_t>(alignof(Block)));
+    return;
+  }
+#endif
+  ::operator delete(p);
+}
+
+template<typename T, typename Count>
+struct intrusive_embedded_block
+{
+  using object_type = intrusive_object<T, Count>;
+
+  template<typename... Args>
+  explicit intrusive_embedded_block(Args&&... args)
+    : header{static_cast<T*>(::new(static_cast<void*>(&storage)) object_type{ std::forward<Args>(args)... }),
+             false, &dispose, &destroy}
+  {
+    assert(header.object == static_cast<void*>(&storage) && "object must be placed at block address");
+    Count::increment(header.pins);
+  }
+
+  static auto of(void *const object) noexcept -> intrusive_embedded_block*
+  {
+    return static_cast<intrusive_embedded_block*>(object);
+  }
+
+  static void dispose(intrusive_block<Count> *const b)
+  {
+    static_cast<T*>(b->object)->~T();
+    unpin(b);
+  }
+
+  static void destroy(intrusive_block<Count> *const b)
+  {
+    const auto self = of(b->object);
+    self->~intrusive_embedded_block();
+    deallocate_block<intrusive_embedded_block>(self);
+  }
+
+  // storage must stay first member, object address is also block address
+  typename std::aligned_storage<sizeof(object_type), alignof(object_type)>::type storage;
+  intrusive_block<Count> header;
+};
+
+template<typename Base, typename Count>
+inline intrusive_object<Base, Count>::~intrusive_object()
+{
+  intrusive_embedded_block<Base, Count>::of(this)->header.deleted.store(true);
+}
+
+template<typename Base, typename Count>
+inline auto intrusive_object<Base, Count>::intrusive_header() noexcept -> intrusive_block<Count>&
+{
+  return intrusive_embedded_block<Base, Count>::of(this)->header;
+}
+
+template<typename Base, typename Count>
+inline void intrusive_object<Base, Count>::operator delete(void *const p) noexcept
+{
+  unpin(&intrusive_embedded_block<Base, Count>::of(p)->header);
+}
+
+// only embeddable types have intrusive_object of their own
+template<typename T, typename Count>
+inline auto exact_embedded_block(std::true_type, T *const object) noexcept -> intrusive_block<Count>*
+{
+  using object_type = intrusive_object<T, Count>;
+  if(typeid(*object) != typeid(object_type))
+    return nullptr;
+
+  return &intrusive_embedded_block<T, Count>::of(static_cast<object_type*>(object))->header;
+}
+
+template<typename T, typename Count>
+inline auto exact_embedded_block(std::false_type, T *const) noexcept -> intrusive_block<Count>*
+{
+  return nullptr;
+}
+
+// Objects made for exactly this type are found by typeid, others by dynamic_cast. Handle
+// keeps one object address, so object found at other address gets separate block.
+template<typename T, typename Count>
+inline auto embedded_block_of(T *const p, std::true_type) noexcept -> intrusive_block<Count>*
+{
+  using type = typename std::remove_cv<T>::type;
+  const auto object = const_cast<type*>(p);
+
+  if(const auto b = exact_embedded_block<type, Count>(is_embeddable<type>{}, object))
+    return b;
+
+  const auto secret = dynamic_cast<intrusive_secret<Count>*>(object);
+  if(!secret || secret->intrusive_header().object != static_cast<void*>(object))
+    return nullptr;
+
+  return &secret->intrusive_header();
+}
+
+template<typename T, typename Count>
+inline auto embedded_block_of(T *const, std::false_type) noexcept -> intrusive_block<Count>*
+{
+  return nullptr;
+}
+
+struct intrusive_factory;
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * basic_owned_pointer has same semantics as owned_pointer, but it is a single pointer
+ * to control block which has refcount, state flags and object address inside.
+ * owned_pointer_st counts are not atomic, compact_owned_pointer ones are.
+ *
+ *****************************************************************************************/
+
+template<typename Tp, typename Count>
+class basic_owned_pointer
+{
+  static_assert(!std::is_array<Tp>::value && !std::is_pointer<Tp>::value, "no array nor pointer supported");
+  using block_type = _priv::intrusive_block<Count>;
+
+#ifdef OWNED_POINTER_STRICT_SAFETY
+  static_assert(
+      _priv::is_embeddable<Tp>::value,
+      "This type is not strictly safe to use with owned_pointer");
+#endif
+
+  template<typename, typename>
+  friend class basic_owned_pointer;
+
+  friend struct _priv::intrusive_factory;
+
+public:
+  using element_type = Tp;
+  using uptr_type = std::unique_ptr<element_type>;
+
+  constexpr basic_owned_pointer() noexcept = default;
+  constexpr basic_owned_pointer(std::nullptr_t) noexcept {}
+
+  basic_owned_pointer(const basic_owned_pointer& p) noexcept : block{p.block} { _priv::add_ref(block); }
+  basic_owned_pointer(basic_owned_pointer&& p) noexcept : block{p.block} { p.block = nullptr; }
+
+  template<typename T>
+  basic_owned_pointer(_priv::link_ptr<T>&& p) : basic_owned_pointer(p.get(), true) {}
+
+  template<typename T>
+  basic_owned_pointer(std::unique_ptr<T>&& p) : basic_owned_pointer(p.release(), false) {}
+
+  ~basic_owned_pointer() { _priv::release(block); }
+
+  auto operator=(basic_owned_pointer p) noexcept -> basic_owned_pointer&
+  {
+    return std::swap(block, p.block), *this;
+  }
+
+  auto get() const -> element_type*;
+  explicit operator uptr_type() const;
+  auto unique_ptr() const -> uptr_type;
+  auto expired() const noexcept -> bool;
+  auto raw_ptr() const -> element_type*;
+  auto acquired() const noexcept -> bool;
+  auto use_count() const noexcept -> long;
+  explicit operator bool() const noexcept;
+  auto operator*() const -> element_type&;
+  auto operator->() const -> element_type*;
+  auto get(std::nothrow_t) const noexcept -> element_type*;
+  auto borrow() const -> borrowed_ptr<element_type>;
+
+  template<typename X = element_type>
+  auto begin() const -> decltype(std::declval<X>().begin()) { return get()->begin(); }
+
+  template<typename X = element_type>
+  auto end() const -> decltype(std::declval<X>().end()) { return get()->end(); }
+
+  template<typename X = element_type>
+  auto cbegin() const -> decltype(std::declval<X>().cbegin()) { return get()->cbegin(); }
+
+  template<typename X = element_type>
+  auto cend() const -> decltype(std::declval<X>().cend()) { return get()->cend(); }
+
+  template<typename X = element_type>
+  auto size() const -> decltype(std::declval<X>().size()) { return get()->size(); }
+
+  template<typename T>
+  operator basic_owned_pointer<T, Count>() const& noexcept;
+
+  template<typename T>
+  operator basic_owned_pointer<T, Count>() && noexcept;
+
+  template<typename T>
+  auto compare(const T& ptr) const noexcept -> std::int8_t;
+
+  template<typename T>
+  auto compare(const basic_owned_pointer<T, Count>& p) const noexcept -> std::int8_t;
+
+private:
+  basic_owned_pointer(element_type *const p, const bool acquired);
+  explicit basic_owned_pointer(block_type *const b) noexcept : block{b} {}
+
+  auto stored_address() const noexcept -> element_type*;
+  void throw_when_expired() const;
+
+  block_type* block{nullptr};
+};
+
+/*****************************************************************************************
+ *
+ * Public member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::get() const -> element_type*
+{
+#ifndef OWNED_POINTER_UNCHECKED_ACCESS
+  throw_when_expired();
+#endif
+  return stored_address();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::operator->() const -> element_type*
+{
+  return get();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::operator*() const -> element_type&
+{
+  return *get();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::unique_ptr() const -> uptr_type
+{
+  throw_when_expired();
+
+  if(!stored_address())
+    return uptr_type { nullptr };
+
+  if(!block->acquired.exchange_if(false, true))
+    throw unique_ptr_already_acquired();
+
+  return uptr_type{stored_address()};
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::raw_ptr() const -> element_type*
+{
+  return unique_ptr().release();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::acquired() const noexcept -> bool
+{
+  return block && block->acquired.load();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::expired() const noexcept -> bool
+{
+  return block && block->deleted.load();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::use_count() const noexcept -> long
+{
+  return block ? C::load(block->uses) : 0;
+}
+
+template<typename T, typename C>
+inline basic_owned_pointer<T, C>::operator uptr_type() const
+{
+  return unique_ptr();
+}
+
+template<typename T, typename C>
+inline basic_owned_pointer<T, C>::operator bool() const noexcept
+{
+  return stored_address();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::get(std::nothrow_t) const noexcept -> element_type*
+{
+  return expired() ? nullptr : stored_address();
+}
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::borrow() const -> borrowed_ptr<element_type>
+{
+  throw_when_expired();
+  return borrowed_ptr<element_type>{stored_address()};
+}
+
+template<typename R, typename C> template<typename T>
+inline basic_owned_pointer<R, C>::operator basic_owned_pointer<T, C>() const& noexcept
+{
+  static_assert(std::is_convertible<element_type*, T*>::value,
+                "Casting to pointer of different or non-derived type");
+
+  return _priv::add_ref(block), basic_owned_pointer<T, C>{block};
+}
+
+template<typename R, typename C> template<typename T>
+inline basic_owned_pointer<R, C>::operator basic_owned_pointer<T, C>() && noexcept
+{
+  static_assert(std::is_convertible<element_type*, T*>::value,
+                "Casting to pointer of different or non-derived type");
+
+  const auto b = block;
+  return block = nullptr, basic_owned_pointer<T, C>{b};
+}
+
+template<typename R, typename C> template<typename T>
+inline auto basic_owned_pointer<R, C>::compare(const T& ptr) const noexcept -> std::int8_t
+{
+  static_assert(std::is_convertible<T, element_type*>::value ||
+                std::is_convertible<element_type*, T>::value,
+                "Comparing pointer of different or non-derived type");
+
+  const void* const addr{stored_address()};
+  const void* const other{ptr};
+  return addr == other ? 0 : (std::less<const void*>()(addr, other) ? -1 : +1);
+}
+
+template<typename R, typename C> template<typename T>
+inline auto basic_owned_pointer<R, C>::compare(const basic_owned_pointer<T, C>& p) const noexcept -> std::int8_t
+{
+  return compare(p.stored_address());
+}
+
+/*****************************************************************************************
+ *
+ * Private member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T, typename C>
+inline auto basic_owned_pointer<T, C>::stored_address() const noexcept -> element_type*
+{
+  return block ? static_cast<element_type*>(block->object) : nullptr;
+}
+
+template<typename T, typename C>
+inline void basic_owned_pointer<T, C>::throw_when_expired() const
+{
+  if(expired())
+    throw ptr_is_already_deleted();
+}
+
+template<typename T, typename C>
+basic_owned_pointer<T, C>::basic_owned_pointer(element_type *const p, const bool acquired)
+{
+  if(!p) return;
+
+  if((block = _priv::embedded_block_of<element_type, C>(p, std::is_polymorphic<element_type>{})))
+    _priv::add_ref(block);
+  else
+    block = _priv::intrusive_separate_block<element_type, C>::create(p, acquired);
+
+  block->acquired.store(acquired);
+}
+
+/*****************************************************************************************
+ *
+ * Public non-member functions
+ *
+ *****************************************************************************************/
+
+namespace _priv
+{
+
+struct intrusive_factory
+{
+  template<typename Object, typename Count, typename... Args>
+  static auto make(std::true_type, Args&&... args) -> basic_owned_pointer<Object, Count>
+  {
+    using block_type = intrusive_embedded_block<Object, Count>;
+
+    const auto memory = allocate_block<block_type>();
+    try
+    {
+      return basic_owned_pointer<Object, Count>{&(::new(memory) block_type(std::forward<Args>(args)...))->header};
+    }
+    catch(...)
+    {
+      deallocate_block<block_type>(memory);
+      throw;
+    }
+  }
+
+  template<typename To, typename From, typename Count>
+  static auto rebind(const basic_owned_pointer<From, Count>& from) noexcept -> basic_owned_pointer<To, Count>
+  {
+    return add_ref(from.block), basic_owned_pointer<To, Count>{from.block};
+  }
+
+  template<typename To, typename From, typename Count>
+  static auto rebind(basic_owned_pointer<From, Count>&& from) noexcept -> basic_owned_pointer<To, Count>
+  {
+    const auto b = from.block;
+    return from.block = nullptr, basic_owned_pointer<To, Count>{b};
+  }
+
+  template<typename Object, typename Count, typename... Args>
+  static auto make(std::false_type, Args&&... args) -> basic_owned_pointer<Object, Count>
+  {
+    std::unique_ptr<Object> object{ new Object{ std::forward<Args>(args)... } };
+    const auto block = intrusive_separate_block<Object, Count>::create(object.get(), false);
+
+    return object.release(), basic_owned_pointer<Object, Count>{block};
+  }
+};
+
+} // namespace _priv
+
+template<typename Object, typename... Args>
+inline auto make_owned_st(Args&&... args) -> owned_pointer_st<Object>
+{
+  return _priv::intrusive_factory::make<Object, _priv::single_thread_count>(
+            _priv::is_embeddable<Object>{}, std::forward<Args>(args)...);
+}
+
+template<typename Object, typename... Args>
+inline auto make_compact_owned(Args&&... args) -> compact_owned_pointer<Object>
+{
+  return _priv::intrusive_factory::make<Object, _priv::atomic_count>(
+            _priv::is_embeddable<Object>{}, std::forward<Args>(args)...);
+}
+
+template<typename To, typename From, typename C>
+inline auto static_pointer_cast(const basic_owned_pointer<From, C>& from) noexcept -> basic_owned_pointer<To, C>
+{
+  return { from };
+}
+
+template<typename To, typename From, typename C>
+inline auto static_pointer_cast(basic_owned_pointer<From, C>&& from) noexcept -> basic_owned_pointer<To, C>
+{
+  return { std::move(from) };
+}
+
+template<typename To, typename From, typename C>
+inline auto dynamic_pointer_cast(const basic_owned_pointer<From, C>& from) noexcept -> basic_owned_pointer<To, C>
+{
+  static_assert(_priv::is_embeddable<From>::value, "Only possible for polymorphic types");
+
+  if(_priv::is_castable<To>(from.get(std::nothrow)))
+    return _priv::intrusive_factory::rebind<To>(from);
+
+  return nullptr;
+}
+
+template<typename To, typename From, typename C>
+inline auto dynamic_pointer_cast(basic_owned_pointer<From, C>&& from) noexcept -> basic_owned_pointer<To, C>
+{
+  static_assert(_priv::is_embeddable<From>::value, "Only possible for polymorphic types");
+
+  if(_priv::is_castable<To>(from.get(std::nothrow)))
+    return _priv::intrusive_factory::rebind<To>(std::move(from));
+
+  return nullptr;
+}
+
+template<typename T, typename C>
+struct is_expired_enabled<basic_owned_pointer<T, C>> : _priv::is_embeddable<T> {};
+
+/*****************************************************************************************
+ *
+ * Public compare operators
+ *
+ *****************************************************************************************/
+
+template<typename A, typename C>
+inline bool operator==(const basic_owned_pointer<A, C>& p1, std::nullptr_t) noexcept
+{
+  return p1.compare(nullptr) == 0;
+}
+
+template<typename A, typename C>
+inline bool operator!=(const basic_owned_pointer<A, C>& p1, std::nullptr_t) noexcept
+{
+  return p1.compare(nullptr) != 0;
+}
+
+template<typename A, typename C>
+inline bool operator==(std::nullptr_t, const basic_owned_pointer<A, C>& p1) noexcept
+{
+  return p1 == nullptr;
+}
+
+template<typename A, typename C>
+inline bool operator!=(std::nullptr_t, const basic_owned_pointer<A, C>& p1) noexcept
+{
+  return p1 != nullptr;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator==(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p1.compare(p2) == 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator!=(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return !(p1 == p2);
+}
+
+template<typename A, typename B, typename C>
+inline bool operator<(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p1.compare(p2) < 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator<=(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p1.compare(p2) <= 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator>(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p1.compare(p2) > 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator>=(const basic_owned_pointer<A, C>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p1.compare(p2) >= 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator==(const basic_owned_pointer<A, C>& p1, const B* p2) noexcept
+{
+  return p1.compare(p2) == 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator==(const A* p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p2.compare(p1) == 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator!=(const basic_owned_pointer<A, C>& p1, const B* p2) noexcept
+{
+  return p1.compare(p2) != 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator!=(const A* p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p2.compare(p1) != 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator==(const basic_owned_pointer<A, C>& p1, const std::unique_ptr<B>& p2) noexcept
+{
+  return p1.compare(p2.get()) == 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator==(const std::unique_ptr<A>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p2.compare(p1.get()) == 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator!=(const basic_owned_pointer<A, C>& p1, const std::unique_ptr<B>& p2) noexcept
+{
+  return p1.compare(p2.get()) != 0;
+}
+
+template<typename A, typename B, typename C>
+inline bool operator!=(const std::unique_ptr<A>& p1, const basic_owned_pointer<B, C>& p2) noexcept
+{
+  return p2.compare(p1.get()) != 0;
+}
+
+} //namespace csp
@@ -23,103 +23,13 @@
 **/
 #pragma once
 
-#include <memory>
-#include <type_traits>
 #include <gmock/gmock.h>
-#include "owned_pointer.hpp"
-
-namespace pobu_gmock
-{
-
-template<const int i, const int n, typename T, typename... Args>
-struct nth_arg
-{
-  typedef typename
-      std::conditional< i == n, T, typename nth_arg<i, n + 1, Args...>::type >::type type;
-};
-
-template<const int i, const int n, typename T>
-struct nth_arg<i, n, T> { typedef T type; };
-
-template<typename T> T& _forward(T& p) { return p; }
-
-template<typename T>
-csp::owned_pointer<T> _forward(std::unique_ptr<T>& u)
-{
-  return { std::move(u) };
-}
-
-template<typename T>
-struct func_signature;
-
-template<typename R, typename... Args>
-struct func_signature<R(Args...)>
-{
-  typedef R result;
-
-  constexpr static unsigned int number_of_args = sizeof...(Args);
-  template<const int i> using arg = typename nth_arg<i, 0, Args...>::type;
-};
-
-template<typename R>
-struct func_signature<R()>
-{
-  typedef R result;
-
-  constexpr static unsigned int number_of_args = 0;
-  template<const int i> using arg = void;
-};
-
-template<typename T>
-struct type_info
-{
-  typedef T type;
-  static const bool is_unique = false;
-};
-
-template<typename T>
-struct type_info<std::unique_ptr<T>>
-{
-  typedef T type;
-  static const bool is_unique = true;
-};
-
-template<typename T>
-struct type_info<const std::unique_ptr<T>>
-{
-  typedef T type;
-  static const bool is_unique = true;
-};
-
-template<typename T, const bool swap>
-struct mock_func_param_deduction
-{
-  static const unsigned int number_of_args = func_signature<T>::number_of_args;
-
-  using result = typename std::conditional
-  <
-    type_info<typename func_signature<T>::result>::is_unique and swap,
-    csp::owned_pointer<
-      typename type_info<typename func_signature<T>::result>::type
-    >,
-    typename func_signature<T>::result
-  >::type;
-
-  template<const int i>
-  using arg = typename std::conditional
-  <
-    type_info<typename func_signature<T>::template arg<i>>::is_unique and swap,
-    csp::owned_pointer<
-      typename type_info<typename func_signature<T>::template arg<i>>::type
-    >,
-    typename func_signature<T>::template arg<i>
-  >::type;
-};
-
-} // namespace pobu_gmock
-
-template<typename T> using s  = pobu_gmock::mock_func_param_deduction<T, true>;
-template<typename T> using r = pobu_gmock::mock_func_param_deduction<T, false>;
+
+// Importers of module csp.owned_pointer.gmock define OWNED_POINTER_IMPORTED, so only
+// macros are parsed here.
+#ifndef OWNED_POINTER_IMPORTED
+#include "gmock_unique_ptr_support.hpp"
+#endif
 
 //-----------------------------------------------------------------------------------------------------------
 
@@ -674,3 +584,131 @@ public:\
                                                       s<signature>::arg<9>))
 
 //-----------------------------------------------------------------------------------------------------------
+
+#ifdef MOCK_METHOD
+
+// Variadic form in style of gmock MOCK_METHOD (gmock 1.10 or newer), e.g.
+//   MOCK_UNIQUE_METHOD(std::unique_ptr<T>, create, (int, std::unique_ptr<U>), (const, override));
+// Mocked function is _create and takes csp::owned_pointer instead of std::unique_ptr.
+// Types with commas have to be put in parentheses, like for MOCK_METHOD. Spec may contain
+// const and override. Up to 14 arguments are supported, more don't fit gmock's checks
+// of parenthesized MOCK_METHOD arguments.
+// Only public MOCK_METHOD is used, helpers below are ours. Dispatch must not go through
+// gmock's preprocessor macros, they would be disabled for nested MOCK_METHOD expansion.
+#define MOCK_UNIQUE_METHOD(...) \
+  POBU_GMOCK_IDENTITY(POBU_GMOCK_CAT(POBU_GMOCK_MOCK_UNIQUE_METHOD_ARG_, POBU_PP_NARG(__VA_ARGS__))(__VA_ARGS__))
+
+#define POBU_GMOCK_IDENTITY(_1) _1
+#define POBU_GMOCK_CAT(_1, _2) POBU_GMOCK_INTERNAL_CAT(_1, _2)
+#define POBU_GMOCK_INTERNAL_CAT(_1, _2) _1 ## _2
+
+#define POBU_GMOCK_MOCK_UNIQUE_METHOD_ARG_3(_Ret, _Name, _Args) \
+  POBU_GMOCK_MOCK_UNIQUE_METHOD_ARG_4(_Ret, _Name, _Args, ())
+
+#define POBU_GMOCK_MOCK_UNIQUE_METHOD_ARG_4(_Ret, _Name, _Args, _Spec) \
+  POBU_GMOCK_MOCK_UNIQUE_METHOD_IMPL(_Args, _Name, _Spec, \
+                                     (POBU_PP_REMOVE_PARENS_IF(_Ret)(POBU_PP_FOR_EACH(POBU_GMOCK_TYPE, ~, _Args))))
+
+#define POBU_GMOCK_MOCK_UNIQUE_METHOD_IMPL(_Args, _Name, _Spec, _Signature) \
+private:\
+r<POBU_PP_REMOVE_PARENS(_Signature)>::result \
+_Name(POBU_PP_FOR_EACH(POBU_GMOCK_PARAMETER, _Signature, _Args)) POBU_GMOCK_SPEC(POBU_GMOCK_QUALIFIER, _Spec) \
+{ \
+  return static_cast<r<POBU_PP_REMOVE_PARENS(_Signature)>::result>( \
+      _ ## _Name(POBU_PP_FOR_EACH(POBU_GMOCK_FORWARD_ARG, _Signature, _Args))); \
+}\
+\
+public:\
+  MOCK_METHOD((s<POBU_PP_REMOVE_PARENS(_Signature)>::result), _ ## _Name, \
+              (POBU_PP_FOR_EACH(POBU_GMOCK_MOCK_ARG, _Signature, _Args)), \
+              (POBU_GMOCK_SPEC(POBU_GMOCK_CONST, _Spec)))
+
+#define POBU_GMOCK_TYPE(_, _i, _Type) POBU_PP_REMOVE_PARENS_IF(_Type)
+
+#define POBU_GMOCK_PARAMETER(_Signature, _i, _) \
+  r<POBU_PP_REMOVE_PARENS(_Signature)>::arg<_i> pobu_a ## _i
+
+#define POBU_GMOCK_FORWARD_ARG(_Signature, _i, _) pobu_gmock::_forward(pobu_a ## _i)
+
+#define POBU_GMOCK_MOCK_ARG(_Signature, _i, _) (s<POBU_PP_REMOVE_PARENS(_Signature)>::arg<_i>)
+
+// Every element of spec is pasted to prefix_, unknown ones fail to compile in wrapper.
+#define POBU_GMOCK_SPEC(_Prefix, _Spec) \
+  POBU_PP_APPLY(POBU_PP_CAT(POBU_GMOCK_SPEC_, POBU_PP_NARG _Spec), (_Prefix, POBU_PP_REMOVE_PARENS_I _Spec))
+#define POBU_GMOCK_SPEC_1(_P, _1) _P ## _ ## _1
+#define POBU_GMOCK_SPEC_2(_P, _1, _2) _P ## _ ## _1 _P ## _ ## _2
+
+#define POBU_GMOCK_QUALIFIER_
+#define POBU_GMOCK_QUALIFIER_const const
+#define POBU_GMOCK_QUALIFIER_override override
+#define POBU_GMOCK_CONST_
+#define POBU_GMOCK_CONST_const const
+#define POBU_GMOCK_CONST_override
+
+#define POBU_PP_CAT(_1, ...) POBU_PP_CAT_I(_1, __VA_ARGS__)
+#define POBU_PP_CAT_I(_1, ...) _1 ## __VA_ARGS__
+#define POBU_PP_APPLY(_Macro, _Args) _Macro _Args
+#define POBU_PP_HEAD(...) POBU_PP_HEAD_I(__VA_ARGS__, ~)
+#define POBU_PP_HEAD_I(_1, ...) _1
+#define POBU_PP_REMOVE_PARENS(_Tuple) POBU_PP_REMOVE_PARENS_I _Tuple
+#define POBU_PP_REMOVE_PARENS_I(...) __VA_ARGS__
+
+#define POBU_PP_16TH(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, ...) _16
+#define POBU_PP_NARG(...) POBU_PP_16TH(__VA_ARGS__, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, ~)
+#define POBU_PP_HAS_COMMA(...) POBU_PP_16TH(__VA_ARGS__, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, ~)
+
+#define POBU_PP_IS_BEGIN_PARENS(...) \
+  POBU_PP_HEAD(POBU_PP_CAT(POBU_PP_IS_BEGIN_PARENS_R_, POBU_PP_IS_BEGIN_PARENS_C __VA_ARGS__))
+#define POBU_PP_IS_BEGIN_PARENS_C(...) 1
+#define POBU_PP_IS_BEGIN_PARENS_R_1 1,
+#define POBU_PP_IS_BEGIN_PARENS_R_POBU_PP_IS_BEGIN_PARENS_C 0,
+
+#define POBU_PP_REMOVE_PARENS_IF(_Type) POBU_PP_CAT(POBU_PP_REMOVE_PARENS_IF_, POBU_PP_IS_BEGIN_PARENS(_Type))(_Type)
+#define POBU_PP_REMOVE_PARENS_IF_0(_Type) _Type
+#define POBU_PP_REMOVE_PARENS_IF_1(_Type) POBU_PP_REMOVE_PARENS_I _Type
+
+// Number of elements, 0 for empty tuple. Single element is empty when it doesn't begin
+// with parentheses, but does when followed by ().
+#define POBU_PP_NARG0(...) POBU_PP_CAT(POBU_PP_NARG0_, POBU_PP_HAS_COMMA(__VA_ARGS__))(__VA_ARGS__)
+#define POBU_PP_NARG0_1(...) POBU_PP_NARG(__VA_ARGS__)
+#define POBU_PP_NARG0_0(_1) POBU_PP_NARG0_IS(POBU_PP_IS_BEGIN_PARENS(_1), POBU_PP_IS_BEGIN_PARENS(_1 ()))
+#define POBU_PP_NARG0_IS(_1, _2) POBU_PP_NARG0_IS_I(_1, _2)
+#define POBU_PP_NARG0_IS_I(_1, _2) POBU_PP_NARG0_ ## _1 ## _2
+#define POBU_PP_NARG0_00 1
+#define POBU_PP_NARG0_01 0
+#define POBU_PP_NARG0_10 1
+#define POBU_PP_NARG0_11 1
+
+// _Macro(_Data, index, element) for each element of tuple, separated by commas.
+#define POBU_PP_FOR_EACH(_Macro, _Data, _Tuple) \
+  POBU_PP_APPLY(POBU_PP_CAT(POBU_PP_FOR_EACH_, POBU_PP_NARG0 _Tuple), (_Macro, _Data, POBU_PP_REMOVE_PARENS_I _Tuple))
+#define POBU_PP_FOR_EACH_0(_Macro, _Data, _)
+#define POBU_PP_FOR_EACH_1(_Macro, _Data, _1) _Macro(_Data, 0, _1)
+#define POBU_PP_FOR_EACH_2(_Macro, _Data, _1, _2) \
+  POBU_PP_FOR_EACH_1(_Macro, _Data, _1), _Macro(_Data, 1, _2)
+#define POBU_PP_FOR_EACH_3(_Macro, _Data, _1, _2, _3) \
+  POBU_PP_FOR_EACH_2(_Macro, _Data, _1, _2), _Macro(_Data, 2, _3)
+#define POBU_PP_FOR_EACH_4(_Macro, _Data, _1, _2, _3, _4) \
+  POBU_PP_FOR_EACH_3(_Macro, _Data, _1, _2, _3), _Macro(_Data, 3, _4)
+#define POBU_PP_FOR_EACH_5(_Macro, _Data, _1, _2, _3, _4, _5) \
+  POBU_PP_FOR_EACH_4(_Macro, _Data, _1, _2, _3, _4), _Macro(_Data, 4, _5)
+#define POBU_PP_FOR_EACH_6(_Macro, _Data, _1, _2, _3, _4, _5, _6) \
+  POBU_PP_FOR_EACH_5(_Macro, _Data, _1, _2, _3, _4, _5), _Macro(_Data, 5, _6)
+#define POBU_PP_FOR_EACH_7(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7) \
+  POBU_PP_FOR_EACH_6(_Macro, _Data, _1, _2, _3, _4, _5, _6), _Macro(_Data, 6, _7)
+#define POBU_PP_FOR_EACH_8(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8) \
+  POBU_PP_FOR_EACH_7(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7), _Macro(_Data, 7, _8)
+#define POBU_PP_FOR_EACH_9(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9) \
+  POBU_PP_FOR_EACH_8(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8), _Macro(_Data, 8, _9)
+#define POBU_PP_FOR_EACH_10(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10) \
+  POBU_PP_FOR_EACH_9(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9), _Macro(_Data, 9, _10)
+#define POBU_PP_FOR_EACH_11(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11) \
+  POBU_PP_FOR_EACH_10(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10), _Macro(_Data, 10, _11)
+#define POBU_PP_FOR_EACH_12(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12) \
+  POBU_PP_FOR_EACH_11(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11), _Macro(_Data, 11, _12)
+#define POBU_PP_FOR_EACH_13(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13) \
+  POBU_PP_FOR_EACH_12(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12), _Macro(_Data, 12, _13)
+#define POBU_PP_FOR_EACH_14(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14) \
+  POBU_PP_FOR_EACH_13(_Macro, _Data, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13), _Macro(_Data, 13, _14)
+
+#endif // MOCK_METHOD
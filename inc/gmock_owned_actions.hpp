@@ -0,0 +1,120 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <functional>
+#ifndef OWNED_POINTER_IMPORTED
+#include "owned_pointer.hpp"
+#endif
+
+namespace csp
+{
+
+/*****************************************************************************************
+ *
+ * Callable usable as gmock action of mocked factory. Every call creates new object
+ * from the same arguments in region shared by all copies, and keeps its handle, so
+ * test can check objects handed out to class under test:
+ *
+ *   csp::owned_factory<StrictMock<D>> objects{1, 2};
+ *   EXPECT_CALL(factory, _create(_)).WillRepeatedly(csp::ReturnOwnedFrom(objects));
+ *   ...
+ *   for(const auto& p : objects.handed_out()) ASSERT_TRUE(p.expired());
+ *
+ *****************************************************************************************/
+
+template<typename T>
+class owned_factory
+{
+public:
+  template<typename... Args>
+  explicit owned_factory(const Args&... args)
+    : shared{std::make_shared<state>([args...](const owned_scope_allocator<char>& a) {
+                return allocate_owned<T>(a, args...);
+              })} {}
+
+  // arguments of mocked function are ignored
+  template<typename... Ignored>
+  auto operator()(const Ignored&...) const -> owned_pointer<T>
+  {
+    const std::lock_guard<std::mutex> lock{shared->mutex};
+    shared->objects.push_back(shared->make(owned_scope_allocator<char>{shared->region}));
+    return shared->objects.back();
+  }
+
+  auto handed_out() const -> std::vector<owned_pointer<T>>
+  {
+    const std::lock_guard<std::mutex> lock{shared->mutex};
+    return shared->objects;
+  }
+
+  auto size() const -> std::size_t
+  {
+    const std::lock_guard<std::mutex> lock{shared->mutex};
+    return shared->objects.size();
+  }
+
+private:
+  struct state
+  {
+    using make_type = std::function<owned_pointer<T>(const owned_scope_allocator<char>&)>;
+
+    explicit state(make_type m) : make{std::move(m)} {}
+
+    state(const state&) = delete;
+    state& operator=(const state&) = delete;
+
+    // objects still used by class under test keep region until they are gone
+    ~state()
+    {
+      objects.clear();
+      region->release();
+    }
+
+    _priv::scope_region *const region{new _priv::scope_region(64 * 1024)};
+    const make_type make;
+    std::mutex mutex;
+    std::vector<owned_pointer<T>> objects;
+  };
+
+  std::shared_ptr<state> shared;
+};
+
+template<typename T, typename... Args>
+inline auto ReturnOwned(const Args&... args) -> owned_factory<T>
+{
+  return owned_factory<T>{args...};
+}
+
+template<typename T>
+inline auto ReturnOwnedFrom(const owned_factory<T>& factory) -> owned_factory<T>
+{
+  return factory;
+}
+
+} // namespace csp
@@ -0,0 +1,164 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <gmock/gmock.h>
+#ifndef OWNED_POINTER_IMPORTED
+#include "owned_pointer.hpp"
+#endif
+
+namespace csp
+{
+
+/*****************************************************************************************
+ *
+ * Matchers of owned_pointer arguments. They keep no handle and read only stored address
+ * and state flags, so they never throw for deleted objects and don't construct lazy ones:
+ *
+ *   EXPECT_CALL(m, _consume(csp::SameObjectAs(p)));
+ *   EXPECT_CALL(m, _consume(csp::PointsToOwned(Field(&D::x, 5))));
+ *   EXPECT_THAT(p, csp::IsExpired());
+ *
+ *****************************************************************************************/
+
+namespace _priv
+{
+
+class same_object_matcher
+{
+public:
+  explicit same_object_matcher(const void *const p) noexcept : address{p} {}
+
+  template<typename Pointer>
+  bool MatchAndExplain(const Pointer& p, ::testing::MatchResultListener*) const
+  {
+    return address_of(p) == address;
+  }
+
+  void DescribeTo(std::ostream *const os) const { *os << "points to the same object as " << address; }
+  void DescribeNegationTo(std::ostream *const os) const { *os << "doesn't point to object at " << address; }
+
+private:
+  const void* address;
+};
+
+class expired_matcher
+{
+public:
+  template<typename Pointer>
+  bool MatchAndExplain(const Pointer& p, ::testing::MatchResultListener*) const { return p.expired(); }
+
+  void DescribeTo(std::ostream *const os) const { *os << "is expired"; }
+  void DescribeNegationTo(std::ostream *const os) const { *os << "isn't expired"; }
+};
+
+class acquired_matcher
+{
+public:
+  template<typename Pointer>
+  bool MatchAndExplain(const Pointer& p, ::testing::MatchResultListener*) const { return p.acquired(); }
+
+  void DescribeTo(std::ostream *const os) const { *os << "is acquired by unique_ptr"; }
+  void DescribeNegationTo(std::ostream *const os) const { *os << "isn't acquired by unique_ptr"; }
+};
+
+// Inner matcher is cast to element type once, when expectation is set. Handle is taken
+// by reference also by Matcher of value, lazy object is not constructed by matching.
+template<typename InnerMatcher>
+class points_to_owned_matcher
+{
+public:
+  explicit points_to_owned_matcher(const InnerMatcher& m) : inner(m) {}
+
+  template<typename Pointer>
+  operator ::testing::Matcher<Pointer>() const
+  {
+    return ::testing::Matcher<Pointer>(new impl<Pointer>(inner));
+  }
+
+private:
+  template<typename Pointer>
+  class impl : public ::testing::MatcherInterface<
+                 typename std::conditional<std::is_reference<Pointer>::value, Pointer, const Pointer&>::type>
+  {
+    using pointer_type = typename std::remove_cv<typename std::remove_reference<Pointer>::type>::type;
+    using element_type = typename pointer_type::element_type;
+    using argument_type = typename std::conditional<std::is_reference<Pointer>::value, Pointer, const Pointer&>::type;
+
+  public:
+    explicit impl(const InnerMatcher& m) : inner(::testing::MatcherCast<const element_type&>(m)) {}
+
+    bool MatchAndExplain(argument_type p, ::testing::MatchResultListener *const listener) const override
+    {
+      const auto object = owned_access::living_address(p);
+      return object != nullptr && inner.MatchAndExplain(*object, listener);
+    }
+
+    void DescribeTo(std::ostream *const os) const override
+    {
+      *os << "points to living object that ";
+      inner.DescribeTo(os);
+    }
+
+    void DescribeNegationTo(std::ostream *const os) const override
+    {
+      *os << "is null, expired, not constructed yet or points to object that ";
+      inner.DescribeNegationTo(os);
+    }
+
+  private:
+    const ::testing::Matcher<const element_type&> inner;
+  };
+
+  const InnerMatcher inner;
+};
+
+} // namespace _priv
+
+template<typename T, typename D>
+inline auto SameObjectAs(const owned_pointer<T, D>& p) -> ::testing::PolymorphicMatcher<_priv::same_object_matcher>
+{
+  return ::testing::MakePolymorphicMatcher(_priv::same_object_matcher{_priv::owned_access::address(p)});
+}
+
+template<typename InnerMatcher>
+inline auto PointsToOwned(const InnerMatcher& m) -> _priv::points_to_owned_matcher<InnerMatcher>
+{
+  return _priv::points_to_owned_matcher<InnerMatcher>{m};
+}
+
+inline auto IsExpired() -> ::testing::PolymorphicMatcher<_priv::expired_matcher>
+{
+  return ::testing::MakePolymorphicMatcher(_priv::expired_matcher{});
+}
+
+inline auto IsAcquired() -> ::testing::PolymorphicMatcher<_priv::acquired_matcher>
+{
+  return ::testing::MakePolymorphicMatcher(_priv::acquired_matcher{});
+}
+
+} // namespace csp
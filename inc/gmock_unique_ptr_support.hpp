@@ -0,0 +1,104 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <tuple>
+#include <memory>
+#include <type_traits>
+#ifndef OWNED_POINTER_IMPORTED
+#include "owned_pointer.hpp"
+#endif
+
+// Type helpers of MOCK_UNIQUE_* macros, they don't need gmock
+
+namespace pobu_gmock
+{
+
+template<typename T> T& _forward(T& p) { return p; }
+
+template<typename T, typename D>
+csp::owned_pointer<T, D> _forward(std::unique_ptr<T, D>& u)
+{
+  return csp::_priv::owned_access::forward(u);
+}
+
+template<typename T>
+struct func_signature;
+
+template<typename R, typename... Args>
+struct func_signature<R(Args...)>
+{
+  typedef R result;
+
+  constexpr static unsigned int number_of_args = sizeof...(Args);
+  template<const int i> using arg = typename std::tuple_element<i, std::tuple<Args...>>::type;
+};
+
+template<typename T>
+struct type_info
+{
+  typedef T type;
+  static const bool is_unique = false;
+};
+
+template<typename T, typename D>
+struct type_info<std::unique_ptr<T, D>>
+{
+  typedef csp::owned_pointer<T, D> type;
+  static const bool is_unique = true;
+};
+
+template<typename T, typename D>
+struct type_info<const std::unique_ptr<T, D>>
+{
+  typedef csp::owned_pointer<T, D> type;
+  static const bool is_unique = true;
+};
+
+template<typename T, const bool swap>
+struct mock_func_param_deduction
+{
+  static const unsigned int number_of_args = func_signature<T>::number_of_args;
+
+  using result = typename std::conditional
+  <
+    type_info<typename func_signature<T>::result>::is_unique and swap,
+    typename type_info<typename func_signature<T>::result>::type,
+    typename func_signature<T>::result
+  >::type;
+
+  template<const int i>
+  using arg = typename std::conditional
+  <
+    type_info<typename func_signature<T>::template arg<i>>::is_unique and swap,
+    typename type_info<typename func_signature<T>::template arg<i>>::type,
+    typename func_signature<T>::template arg<i>
+  >::type;
+};
+
+} // namespace pobu_gmock
+
+// Classes rather than alias templates, so they can be exported from module
+template<typename T> struct s : pobu_gmock::mock_func_param_deduction<T, true> {};
+template<typename T> struct r : pobu_gmock::mock_func_param_deduction<T, false> {};
@@ -0,0 +1,67 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <ostream>
+#include <iostream>
+#include <gtest/gtest.h>
+#include "owned_pointer.hpp"
+
+namespace csp
+{
+
+/*****************************************************************************************
+ *
+ * Prints lifecycle counters of every type created in test suite and resets them. Types
+ * with many more created than acquired objects are mocks built but never used.
+ *
+ *   ::testing::UnitTest::GetInstance()->listeners().Append(new csp::lifecycle_stats_listener);
+ *
+ *****************************************************************************************/
+
+class lifecycle_stats_listener : public ::testing::EmptyTestEventListener
+{
+public:
+  explicit lifecycle_stats_listener(std::ostream& o = std::cout) : out(o) {}
+
+  void OnTestSuiteStart(const ::testing::TestSuite&) override { reset_lifecycle_stats(); }
+
+  void OnTestSuiteEnd(const ::testing::TestSuite& suite) override
+  {
+    for(const auto& c : lifecycle_stats())
+    {
+      if(!c.created) continue;
+
+      out << "[ owned    ] " << suite.name() << ": " << c.type_name
+          << " created " << c.created << ", acquired " << c.acquired
+          << ", expired " << c.expired << ", deleted not acquired " << c.deleted_not_acquired
+          << ", live " << c.live << " (max " << c.live_high_water << ")\n";
+    }
+  }
+
+private:
+  std::ostream& out;
+};
+
+} // namespace csp
@@ -0,0 +1,80 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <gtest/gtest.h>
+#include "owned_pointer.hpp"
+
+namespace csp
+{
+
+/*****************************************************************************************
+ *
+ * Member of test fixture, which labels objects created in test with its name and fails
+ * test in TearDown for every object from make_owned, which was acquired by unique_ptr()
+ * and never deleted. Requires define OWNED_POINTER_REGISTRY.
+ *
+ *   struct my_test : ::testing::Test
+ *   {
+ *     csp::owned_leak_check leaks;
+ *     void TearDown() override { leaks.verify(); }
+ *   };
+ *
+ *****************************************************************************************/
+
+class owned_leak_check
+{
+public:
+  owned_leak_check() : site{test_name()}, mark{registry_mark()} {}
+
+  void verify() const
+  {
+    for(const auto& o : leaked_objects(mark))
+      ADD_FAILURE() << "owned_pointer: object " << o.address << " of type " << o.type_name
+                    << " created in " << o.site << " was acquired by unique_ptr and never deleted";
+  }
+
+private:
+  // Names are kept for whole run, objects leaked by test may outlive its fixture
+  static auto test_name() -> const char*
+  {
+    static std::mutex m;
+    static std::deque<std::string> names;
+
+    const auto info = ::testing::UnitTest::GetInstance()->current_test_info();
+    if(!info) return "unknown";
+
+    const std::lock_guard<std::mutex> lock{m};
+    names.push_back(std::string{info->test_suite_name()} + "." + info->name());
+    return names.back().c_str();
+  }
+
+  const registry_site site;
+  const std::uint64_t mark;
+};
+
+} // namespace csp
@@ -0,0 +1,282 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include "owned_pointer.hpp"
+
+namespace csp
+{
+
+/*****************************************************************************************
+ *
+ * owned_map is open addressing map keyed by owned_pointer. Index slots keep stored
+ * address of key next to position of its entry, so lookup by handle, raw pointer or
+ * std::unique_ptr never touches control blocks. Entries are dense, erase moves the last
+ * one into the gap. Keys must not be changed through iterators, null handle is never
+ * a key. Address of separate object can be reused after it was deleted, embedded ones
+ * keep their memory while key exists.
+ *
+ *****************************************************************************************/
+
+template<typename T, typename V>
+class owned_map
+{
+public:
+  using key_type = owned_pointer<T>;
+  using mapped_type = V;
+  using value_type = std::pair<key_type, V>;
+  using size_type = std::size_t;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  owned_map() = default;
+
+  template<typename... Args>
+  auto emplace(key_type k, Args&&... args) -> std::pair<iterator, bool>;
+  auto insert(key_type k, V v) -> std::pair<iterator, bool> { return emplace(std::move(k), std::move(v)); }
+
+  template<typename K>
+  auto find(const K& k) noexcept -> iterator;
+
+  template<typename K>
+  auto find(const K& k) const noexcept -> const_iterator;
+
+  template<typename K>
+  auto contains(const K& k) const noexcept -> bool { return find(k) != end(); }
+
+  template<typename K>
+  auto at(const K& k) -> V&;
+
+  template<typename K>
+  auto at(const K& k) const -> const V&;
+
+  template<typename K>
+  auto erase(const K& k) -> size_type;
+
+  void clear() noexcept;
+  void reserve(const size_type n);
+
+  auto size() const noexcept -> size_type { return entries.size(); }
+  auto empty() const noexcept -> bool { return entries.empty(); }
+
+  auto begin() noexcept -> iterator { return entries.begin(); }
+  auto end() noexcept -> iterator { return entries.end(); }
+  auto begin() const noexcept -> const_iterator { return entries.begin(); }
+  auto end() const noexcept -> const_iterator { return entries.end(); }
+
+private:
+  struct slot
+  {
+    const void* address;
+    size_type entry;
+  };
+
+  static constexpr size_type min_slots = 16;
+
+  // Fibonacci hashing, addresses of objects differ in upper bits
+  auto home(const void *const a) const noexcept -> size_type
+  {
+    return static_cast<size_type>((reinterpret_cast<std::uintptr_t>(a) * std::uint64_t{0x9E3779B97F4A7C15}) >> shift);
+  }
+
+  auto mask() const noexcept -> size_type { return slots.size() - 1; }
+
+  // slot of address or empty slot, where it would be
+  auto probe(const void *const a) const noexcept -> size_type
+  {
+    auto i = home(a);
+    while(slots[i].address && slots[i].address != a)
+      i = (i + 1) & mask();
+
+    return i;
+  }
+
+  auto find_slot(const void *const a) const noexcept -> const slot*
+  {
+    if(!a || slots.empty())
+      return nullptr;
+
+    const auto& s = slots[probe(a)];
+    return s.address ? &s : nullptr;
+  }
+
+  void rehash(const size_type n);
+  void erase_slot(size_type i) noexcept;
+
+  std::vector<slot> slots;
+  std::vector<value_type> entries;
+  unsigned shift{64};
+};
+
+/*****************************************************************************************
+ *
+ * Public member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T, typename V> template<typename... Args>
+auto owned_map<T, V>::emplace(key_type k, Args&&... args) -> std::pair<iterator, bool>
+{
+  const auto a = _priv::address_of(k);
+  if(!a)
+    return {end(), false};
+
+  // load factor stays at most 1/2
+  if(2 * (entries.size() + 1) > slots.size())
+    rehash(slots.empty() ? min_slots : 2 * slots.size());
+
+  const auto i = probe(a);
+  if(slots[i].address)
+    return {begin() + slots[i].entry, false};
+
+  entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+  slots[i] = {a, entries.size() - 1};
+
+  return {end() - 1, true};
+}
+
+template<typename T, typename V> template<typename K>
+auto owned_map<T, V>::find(const K& k) noexcept -> iterator
+{
+  const auto s = find_slot(_priv::address_of(k));
+  return s ? begin() + s->entry : end();
+}
+
+template<typename T, typename V> template<typename K>
+auto owned_map<T, V>::find(const K& k) const noexcept -> const_iterator
+{
+  const auto s = find_slot(_priv::address_of(k));
+  return s ? begin() + s->entry : end();
+}
+
+template<typename T, typename V> template<typename K>
+auto owned_map<T, V>::at(const K& k) -> V&
+{
+  const auto it = find(k);
+  if(it == end())
+    throw std::out_of_range("owned_map: No such key");
+
+  return it->second;
+}
+
+template<typename T, typename V> template<typename K>
+auto owned_map<T, V>::at(const K& k) const -> const V&
+{
+  const auto it = find(k);
+  if(it == end())
+    throw std::out_of_range("owned_map: No such key");
+
+  return it->second;
+}
+
+template<typename T, typename V> template<typename K>
+auto owned_map<T, V>::erase(const K& k) -> size_type
+{
+  const auto a = _priv::address_of(k);
+  if(!find_slot(a))
+    return 0;
+
+  const auto i = probe(a);
+  const auto e = slots[i].entry;
+  erase_slot(i);
+
+  if(e != entries.size() - 1)
+  {
+    slots[probe(_priv::address_of(entries.back().first))].entry = e;
+    entries[e] = std::move(entries.back());
+  }
+
+  entries.pop_back();
+  return 1;
+}
+
+template<typename T, typename V>
+void owned_map<T, V>::clear() noexcept
+{
+  entries.clear();
+  for(auto& s : slots)
+    s.address = nullptr;
+}
+
+template<typename T, typename V>
+void owned_map<T, V>::reserve(const size_type n)
+{
+  auto size = slots.empty() ? min_slots : slots.size();
+  while(size < 2 * n)
+    size *= 2;
+
+  entries.reserve(n);
+  if(size != slots.size())
+    rehash(size);
+}
+
+/*****************************************************************************************
+ *
+ * Private member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T, typename V>
+void owned_map<T, V>::rehash(const size_type n)
+{
+  slots.assign(n, slot{nullptr, 0});
+
+  shift = 64;
+  for(auto s = n; s > 1; s /= 2)
+    --shift;
+
+  for(size_type e = 0; e < entries.size(); e++)
+  {
+    const auto a = _priv::address_of(entries[e].first);
+    slots[probe(a)] = {a, e};
+  }
+}
+
+// backward shift keeps probe sequences without tombstones
+template<typename T, typename V>
+void owned_map<T, V>::erase_slot(size_type i) noexcept
+{
+  for(auto j = (i + 1) & mask(); slots[j].address; j = (j + 1) & mask())
+  {
+    const auto h = home(slots[j].address);
+    const bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+
+    if(!stays)
+    {
+      slots[i] = slots[j];
+      i = j;
+    }
+  }
+
+  slots[i].address = nullptr;
+}
+
+} //namespace csp
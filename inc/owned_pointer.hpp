@@ -24,11 +24,35 @@
 #pragma once
 
 #include <new>
+#include <mutex>
 #include <tuple>
+#include <thread>
+#include <atomic>
 #include <memory>
+#include <vector>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <typeinfo>
+#include <stdexcept>
 #include <exception>
+#include <functional>
 #include <type_traits>
+#include "owned_pointer_fwd.hpp"
+#include "owned_pointer_stats.hpp"
+#include "owned_pointer_registry.hpp"
+#include "owned_pointer_deletion.hpp"
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#  if __has_include(<memory_resource>)
+#    include <memory_resource>
+#    define OWNED_POINTER_HAS_PMR 1
+#  endif
+#endif
+
+#ifndef OWNED_POINTER_HAS_PMR
+#  define OWNED_POINTER_HAS_PMR 0
+#endif
 
 namespace csp
 {
@@ -36,6 +60,7 @@ namespace csp
 namespace _priv
 {
 template<typename> class link_ptr;
+struct owned_access;
 }
 
 template<typename T>
@@ -47,47 +72,844 @@ auto link(const std::unique_ptr<T>& u) noexcept -> _priv::link_ptr<R>;
 namespace _priv
 {
 
-using control_block_type = std::tuple<void*, bool, bool>;
+#ifdef OWNED_POINTER_THREAD_SAFE
+class state_flag
+{
+public:
+  state_flag(const bool v) noexcept : value{v} {}
+
+  auto load() const noexcept -> bool { return value.load(std::memory_order_acquire); }
+  void store(const bool v) noexcept { value.store(v, std::memory_order_release); }
+
+  auto exchange_if(bool expected, const bool desired) noexcept -> bool
+  {
+    return value.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<bool> value;
+};
+
+// Object is not acquired, acquired by unique_ptr() or shared by shared_ptr(). Sharing is the
+// same compare and swap as acquiring, so racing first shares agree on the result.
+class acquire_state
+{
+public:
+  enum value_type : unsigned char { none, unique, shared };
+
+  acquire_state(const bool a) noexcept : value{a ? unique : none} {}
+
+  auto load() const noexcept -> bool { return value.load(std::memory_order_acquire) != none; }
+  auto is_shared() const noexcept -> bool { return value.load(std::memory_order_acquire) == shared; }
+  void store(const bool a) noexcept { value.store(a ? unique : none, std::memory_order_release); }
+
+  auto exchange_if(const bool expected, const bool desired) noexcept -> bool
+  {
+    auto e = expected ? unique : none;
+    return value.compare_exchange_strong(e, desired ? unique : none, std::memory_order_acq_rel, std::memory_order_acquire);
+  }
+
+  // state before the call, object is shared now unless it was unique
+  auto share() noexcept -> value_type
+  {
+    auto e = none;
+    value.compare_exchange_strong(e, shared, std::memory_order_acq_rel, std::memory_order_acquire);
+    return e;
+  }
+
+private:
+  std::atomic<value_type> value;
+};
+#else
+class state_flag
+{
+public:
+  state_flag(const bool v) noexcept : value{v} {}
+
+  auto load() const noexcept -> bool { return value; }
+  void store(const bool v) noexcept { value = v; }
+
+  auto exchange_if(const bool expected, const bool desired) noexcept -> bool
+  {
+    return value == expected ? (value = desired, true) : false;
+  }
+
+private:
+  bool value;
+};
+
+class acquire_state
+{
+public:
+  enum value_type : unsigned char { none, unique, shared };
+
+  acquire_state(const bool a) noexcept : value{a ? unique : none} {}
+
+  auto load() const noexcept -> bool { return value != none; }
+  auto is_shared() const noexcept -> bool { return value == shared; }
+  void store(const bool a) noexcept { value = a ? unique : none; }
+
+  auto exchange_if(const bool expected, const bool desired) noexcept -> bool
+  {
+    return value == (expected ? unique : none) ? (value = desired ? unique : none, true) : false;
+  }
+
+  auto share() noexcept -> value_type
+  {
+    const auto e = value;
+    return value = e == none ? shared : e, e;
+  }
+
+private:
+  value_type value;
+};
+#endif
+
+// control blocks served from one region are padded to it, when thread safe
+constexpr std::size_t cache_line_size = 64;
+
+// Container of owned_pointers registers itself in control block to learn
+// about state changes without polling every block.
+class state_observer
+{
+public:
+  virtual void deleted(std::size_t slot) noexcept = 0;
+  virtual void acquired(std::size_t slot, bool value) noexcept = 0;
+
+protected:
+  ~state_observer() = default;
+};
+
+// Waits for deletion of object. Listener is linked in control block until object is
+// deleted or until block is destroyed with object still alive.
+class expiry_listener
+{
+public:
+  virtual void expired() noexcept = 0;
+  virtual void dropped() noexcept = 0;
+
+  expiry_listener* next{nullptr};
+
+protected:
+  ~expiry_listener() = default;
+};
+
+struct control_block_type;
+class lazy_constructor;
+
+// State used only by owned_pointer_set, expiry listeners and make_owned_lazy. Control
+// block has one pointer to it, which is set when first needed.
+struct block_extras
+{
+  explicit block_extras(const bool h = true) noexcept : heap{h} {}
+
+  // observer_slot is written before observer is published, observer is detached
+  // only when no notification uses it (observer_users is zero)
+  std::atomic<state_observer*> observer{nullptr};
+  std::atomic<unsigned> observer_users{0};
+  std::size_t observer_slot{0};
+
+  // list of expiry_listener, fired_listeners() when object was deleted
+  std::atomic<expiry_listener*> listeners{nullptr};
+
+  // set while object of make_owned_lazy may be not constructed yet
+  lazy_constructor* lazy{nullptr};
+
+  // false when extras live inside block
+  const bool heap;
+};
+
+// Object from make_owned_lazy is constructed on first use
+class lazy_constructor
+{
+public:
+  // call_once is taken only until object exists
+  void construct()
+  {
+    if(!constructed.load(std::memory_order_acquire))
+      std::call_once(once, &lazy_constructor::construct_once, this);
+  }
+
+  auto is_constructed() const noexcept -> bool { return constructed.load(std::memory_order_acquire); }
+
+protected:
+  lazy_constructor() noexcept { extras.lazy = this; }
+  ~lazy_constructor() = default;
+  virtual void create() = 0;
+
+  std::atomic<bool> constructed{false};
+  block_extras extras{false};
+
+private:
+  void construct_once()
+  {
+    create();
+    constructed.store(true, std::memory_order_release);
+  }
+
+  std::once_flag once;
+};
+
+struct control_block_type
+{
+  control_block_type(void *const p, const bool a, const bool e = false) noexcept
+    : object{p}, acquired{a}, deleted{false}, embedded{e} {}
+
+  ~control_block_type();
+
+  void* object;
+
+  // Object given away by shared_ptr() stays owned by this block, it is
+  // shared only to stop unique_ptr() from handing it out.
+  acquire_state acquired;
+  state_flag deleted;
+  const bool embedded;
+
+  // Only used when object shares allocation with this block. Block must
+  // outlive an acquired object, so it holds itself until object is deleted.
+  std::shared_ptr<control_block_type> keep_alive;
+
+  // closed_extras() when object was deleted before extras were needed
+  std::atomic<block_extras*> extras{nullptr};
+
+#ifdef OWNED_POINTER_STATS
+  lifecycle_record* stats{nullptr};
+#endif
+
+#ifdef OWNED_POINTER_REGISTRY
+  std::atomic<control_block_type*>* registry_slot{nullptr};
+  const char* type_name{nullptr};
+  const char* site{nullptr};
+  std::uint64_t serial{0};
+#endif
+};
+
+inline auto ptr(control_block_type& cb) noexcept -> void* { return cb.object; }
+inline auto deleted(control_block_type& cb) noexcept -> state_flag& { return cb.deleted; }
+inline auto acquired(control_block_type& cb) noexcept -> acquire_state& { return cb.acquired; }
+
+inline auto closed_extras() noexcept -> block_extras*
+{
+  static block_extras closed{false};
+  return &closed;
+}
+
+inline auto extras_of(const control_block_type& cb) noexcept -> block_extras*
+{
+  const auto e = cb.extras.load(std::memory_order_acquire);
+  return e == closed_extras() ? nullptr : e;
+}
+
+// nullptr when object was deleted before, nothing can be observed then
+inline auto install_extras(control_block_type& cb) -> block_extras*
+{
+  auto e = cb.extras.load(std::memory_order_acquire);
+  if(!e)
+  {
+    std::unique_ptr<block_extras> fresh{new block_extras};
+    if(cb.extras.compare_exchange_strong(e, fresh.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+      return fresh.release();
+  }
+
+  return e == closed_extras() ? nullptr : e;
+}
+
+// Observer is loaded again after registering as its user, so detach_observer() either
+// sees the user and waits, or this notification sees observer already detached.
+template<typename F>
+inline void notify(control_block_type& cb, F f) noexcept
+{
+  const auto e = extras_of(cb);
+  if(!e || !e->observer.load(std::memory_order_acquire))
+    return;
+
+  e->observer_users.fetch_add(1, std::memory_order_seq_cst);
+  if(const auto o = e->observer.load(std::memory_order_seq_cst))
+    f(*o, e->observer_slot);
+  e->observer_users.fetch_sub(1, std::memory_order_release);
+}
+
+inline void notify_acquired(control_block_type& cb, const bool value) noexcept
+{
+  notify(cb, [value](state_observer& o, const std::size_t slot){ o.acquired(slot, value); });
+}
+
+inline void notify_deleted(control_block_type& cb) noexcept
+{
+  notify(cb, [](state_observer& o, const std::size_t slot){ o.deleted(slot); });
+}
+
+// extras come from install_extras(), deleted object has none and is not attached
+inline void attach_observer(block_extras& e, state_observer *const o, const std::size_t slot) noexcept
+{
+  e.observer_slot = slot;
+  e.observer.store(o, std::memory_order_release);
+}
+
+// after return no notification touches observer nor its slot
+inline void detach_observer(control_block_type& cb) noexcept
+{
+  const auto e = extras_of(cb);
+  if(!e) return;
 
-const auto ptr      = +[](control_block_type& cb) -> void* { return std::get<0>(cb); };
-const auto deleted  = +[](control_block_type& cb) -> bool& { return std::get<2>(cb); };
-const auto acquired = +[](control_block_type& cb) -> bool& { return std::get<1>(cb); };
+  e->observer.store(nullptr, std::memory_order_seq_cst);
+  while(e->observer_users.load(std::memory_order_acquire))
+    std::this_thread::yield();
+}
+
+struct fired_listeners_type final : expiry_listener
+{
+  void expired() noexcept override {}
+  void dropped() noexcept override {}
+};
+
+inline auto fired_listeners() noexcept -> expiry_listener*
+{
+  static fired_listeners_type fired;
+  return &fired;
+}
+
+// Object already deleted has no listeners or fired_listeners(), add_listener() checks
+// deleted first. Without OWNED_POINTER_THREAD_SAFE nobody can add listener meanwhile,
+// so missing extras or empty list are only loaded. Thread safe deletion closes missing
+// extras and exchanges list, which orders it with add_listener() without full fence.
+inline auto take_listeners(control_block_type& cb) noexcept -> expiry_listener*
+{
+  auto e = cb.extras.load(std::memory_order_acquire);
+
+#ifdef OWNED_POINTER_THREAD_SAFE
+  if(!e && cb.extras.compare_exchange_strong(e, closed_extras(), std::memory_order_acq_rel, std::memory_order_acquire))
+    return nullptr;
+#endif
+
+  if(!e || e == closed_extras())
+    return nullptr;
+
+#ifndef OWNED_POINTER_THREAD_SAFE
+  if(!e->listeners.load(std::memory_order_relaxed))
+    return nullptr;
+#endif
+
+  const auto l = e->listeners.exchange(fired_listeners(), std::memory_order_acq_rel);
+  return l == fired_listeners() ? nullptr : l;
+}
+
+inline void fire(expiry_listener* l) noexcept
+{
+  while(l)
+  {
+    const auto next = l->next;
+    l->expired();
+    l = next;
+  }
+}
+
+// false when object is already deleted, listener is not linked then
+inline auto add_listener(control_block_type& cb, expiry_listener *const l) -> bool
+{
+  if(deleted(cb).load())
+    return false;
+
+  const auto e = install_extras(cb);
+  if(!e)
+    return false;
+
+  auto head = e->listeners.load(std::memory_order_acquire);
+  do
+  {
+    if(head == fired_listeners())
+      return false;
+
+    l->next = head;
+  }
+  while(!e->listeners.compare_exchange_weak(head, l, std::memory_order_acq_rel, std::memory_order_acquire));
+
+  return true;
+}
+
+inline control_block_type::~control_block_type()
+{
+  const auto e = extras_of(*this);
+  if(!e) return;
+
+  auto l = e->listeners.load(std::memory_order_acquire);
+  while(l && l != fired_listeners())
+  {
+    const auto next = l->next;
+    l->dropped();
+    l = next;
+  }
+
+  if(e->heap)
+    delete e;
+}
+
+#ifdef OWNED_POINTER_REGISTRY
+inline auto live_blocks() noexcept -> sharded_registry<control_block_type>&
+{
+  static sharded_registry<control_block_type> registry;
+  return registry;
+}
+#endif
 
 template<typename T>
-struct owned_deleter
+inline void track_created(control_block_type& cb) noexcept
+{
+#ifdef OWNED_POINTER_STATS
+  cb.stats = &lifecycle_record_of<T>();
+  cb.stats->created();
+#endif
+#ifdef OWNED_POINTER_REGISTRY
+  cb.type_name = typeid(T).name();
+  cb.site = current_site();
+  cb.serial = registry_serial().fetch_add(1, std::memory_order_relaxed);
+  cb.registry_slot = live_blocks().insert(&cb);
+#endif
+  (void)cb;
+}
+
+inline void track_destroyed(control_block_type& cb) noexcept
 {
-  void operator()(control_block_type *const cb)
+#ifdef OWNED_POINTER_STATS
+  cb.stats->destroyed();
+#endif
+#ifdef OWNED_POINTER_REGISTRY
+  if(cb.registry_slot) live_blocks().remove(cb.registry_slot);
+#endif
+  (void)cb;
+}
+
+#ifdef OWNED_POINTER_STATS
+inline void track(control_block_type& cb, const lifecycle_event e) noexcept { cb.stats->count(e); }
+#else
+inline void track(control_block_type&, lifecycle_event) noexcept {}
+#endif
+
+inline void set_acquired(const std::shared_ptr<control_block_type>& cb, const bool value)
+{
+  if(value && !acquired(*cb).load())
+    track(*cb, acquired_event);
+
+  acquired(*cb).store(value);
+
+  if(cb->embedded)
+    cb->keep_alive = value ? cb : nullptr;
+
+  notify_acquired(*cb, value);
+}
+
+inline auto try_acquire(const std::shared_ptr<control_block_type>& cb) -> bool
+{
+  if(!acquired(*cb).exchange_if(false, true))
+    return false;
+
+  if(cb->embedded)
+    cb->keep_alive = cb;
+
+  track(*cb, acquired_event);
+  return notify_acquired(*cb, true), true;
+}
+
+// Consumes cb on success: an embedded block takes it over as its keep_alive
+// handle, so acquiring from a temporary costs no reference count traffic.
+// Block is tracked and notified before cb is given away, it may be the last
+// handle of a separate block.
+inline auto try_acquire(std::shared_ptr<control_block_type>&& cb) -> bool
+{
+  auto& block = *cb;
+
+  if(!acquired(block).exchange_if(false, true))
+    return false;
+
+  track(block, acquired_event);
+  notify_acquired(block, true);
+
+  // separate block may die here together with the last handle
+  if(block.embedded)
+    block.keep_alive = std::move(cb);
+  else
+    cb.reset();
+
+  return true;
+}
+
+// First share takes object the same way as unique_ptr() does, later calls only
+// check it was shared.
+inline auto try_share(control_block_type& cb) -> bool
+{
+  if(acquired(cb).is_shared())
+    return true;
+
+  switch(acquired(cb).share())
+  {
+    case acquire_state::none: break;
+    case acquire_state::shared: return true;
+    case acquire_state::unique: return false;
+  }
+
+  track(cb, acquired_event);
+  return notify_acquired(cb, true), true;
+}
+
+template<typename T>
+struct embedded_deleter
+{
+  void operator()(T *const p) const { p->~T(); }
+};
+
+template<typename T, typename Deleter>
+inline void release_when_not_acquired(control_block_type& cb, Deleter&& deleter)
+{
+  using element_type = typename std::remove_extent<T>::type;
+
+  // last std::shared_ptr or owned_pointer of shared object deletes it
+  if(acquired(cb).is_shared())
   {
+    deleter(static_cast<element_type*>(ptr(cb)));
+    return;
+  }
+
 #ifdef OWNED_POINTER_ASSERT_DTOR
-    assert(acquired(*cb) && "ASSERT: you created owned_pointer, but unique_ptr was never acquired");
+  (void)deleter;
+  assert(acquired(cb).load() && "ASSERT: you created owned_pointer, but unique_ptr was never acquired");
 #else
-    if(!acquired(*cb))
-      delete static_cast<T*>(ptr(*cb));
+  if(!acquired(cb).load())
+  {
+    track(cb, not_acquired_event);
+    deleter(static_cast<element_type*>(ptr(cb)));
+  }
 #endif
-    delete cb;
+}
+
+// Objects of T are deleted by default_delete, when T is not array, so its deletion
+// can be reported by T's operator delete.
+template<typename T>
+struct is_watched : std::integral_constant<bool, !std::is_array<T>::value &&
+                                                 track_deletion<typename std::remove_cv<T>::type>::value> {};
+
+// embedded_object can derive from T
+template<typename T>
+struct is_embeddable :
+  std::integral_constant<bool, std::has_virtual_destructor<T>::value
+                                #if __cplusplus >= 201402L
+                                  && !std::is_final<T>::value
+                                #elif defined(__GNUC__) || defined(__clang__)
+                                  && !__is_final(T)
+                                #endif
+                        > {};
+
+template<typename T>
+struct is_expired_enabled : std::integral_constant<bool, is_embeddable<T>::value || is_watched<T>::value> {};
+
+inline void mark_expired(control_block_type& cb) noexcept
+{
+  deleted(cb).store(true);
+  track(cb, expired_event);
+  notify_deleted(cb);
+}
+
+// listeners are fired when shard of deletion table is unlocked, block may be gone then
+inline void expire_watched(void *const block, void*& pending) noexcept
+{
+  auto& cb = *static_cast<control_block_type*>(block);
+  mark_expired(cb);
+
+  if(const auto l = take_listeners(cb))
+  {
+    auto tail = l;
+    while(tail->next) tail = tail->next;
+
+    tail->next = static_cast<expiry_listener*>(pending);
+    pending = l;
   }
-};
+}
 
+inline void fire_pending(void *const pending) noexcept
+{
+  fire(static_cast<expiry_listener*>(pending));
+}
+
+inline void watch_deletion(std::true_type, control_block_type& cb) noexcept
+{
+  deleted_objects().watch(ptr(cb), &cb, &expire_watched, &fire_pending);
+}
+
+inline void unwatch_deletion(std::true_type, control_block_type& cb) noexcept
+{
+  deleted_objects().unwatch(ptr(cb), &cb);
+}
+
+inline void watch_deletion(std::false_type, control_block_type&) noexcept {}
+inline void unwatch_deletion(std::false_type, control_block_type&) noexcept {}
+
+// Costs one vptr in object, pointer to any its base finds control block by dynamic_cast
 class shared_secret
 {
 public:
-  std::weak_ptr<control_block_type> control_block;
-  virtual ~shared_secret() = default;
+  virtual auto embedded_control_block() noexcept -> control_block_type& = 0;
 
 protected:
-  void delete_event() noexcept
+  ~shared_secret() = default;
+};
+
+// Only reached from operator delete, object deleted by its block is not. Without
+// set or listeners it is one store of deleted and one load of extras (compare and swap
+// with OWNED_POINTER_THREAD_SAFE, see take_listeners()). Release of keep_alive by the
+// caller stays: acquired object holds the last reference to its block.
+inline void expire_embedded(control_block_type& cb) noexcept
+{
+  deleted(cb).store(true);
+  track(cb, expired_event);
+
+  auto e = cb.extras.load(std::memory_order_acquire);
+
+#ifdef OWNED_POINTER_THREAD_SAFE
+  if(!e && cb.extras.compare_exchange_strong(e, closed_extras(), std::memory_order_acq_rel, std::memory_order_acquire))
+    return;
+#endif
+
+  if(!e || e == closed_extras())
+    return;
+
+  notify_deleted(cb);
+  fire(take_listeners(cb));
+}
+
+template<typename T>
+struct separate_block
+{
+  using element_type = typename std::remove_extent<T>::type;
+
+  separate_block(element_type *const p, const bool a) noexcept : cb{p, a}
+  {
+    track_created<T>(cb);
+    watch_deletion(is_watched<T>{}, cb);
+  }
+
+  template<typename D>
+  separate_block(element_type *const p, const bool a, D&&) noexcept : separate_block(p, a) {}
+
+  // object deleted with its last handle is not reported, as from embedded_block
+  ~separate_block()
+  {
+    unwatch_deletion(is_watched<T>{}, cb);
+    release_when_not_acquired<T>(cb, std::default_delete<T>{});
+    track_destroyed(cb);
+  }
+
+  static auto deleter(control_block_type&) noexcept -> std::default_delete<T> { return {}; }
+
+  control_block_type cb;
+};
+
+// Block of owned_pointer<T, Deleter>, unique_ptr() hands out a copy of stored deleter.
+template<typename T, typename Deleter>
+struct deleter_block
+{
+  using element_type = typename std::remove_extent<T>::type;
+
+  deleter_block(element_type *const p, const bool a) : deleter_block(p, a, Deleter()) {}
+
+  template<typename D>
+  deleter_block(element_type *const p, const bool a, D&& d) : cb{p, a}, stored(std::forward<D>(d))
+  {
+    track_created<T>(cb);
+  }
+
+  ~deleter_block()
   {
-    if(auto p{control_block.lock()}) deleted(*p) = true;
+    release_when_not_acquired<T>(cb, stored);
+    track_destroyed(cb);
   }
+
+  static auto deleter(control_block_type& cb) noexcept -> Deleter&
+  {
+    return reinterpret_cast<deleter_block&>(cb).stored;
+  }
+
+  // cb must stay first member, block address is also cb address
+  control_block_type cb;
+  Deleter stored;
 };
 
+template<typename T, typename Deleter>
+struct block_of { using type = deleter_block<T, Deleter>; };
+
+template<typename T>
+struct block_of<T, std::default_delete<T>> { using type = separate_block<T>; };
+
+// Object is the first member of its embedded_block, which outlives it.
 template<typename Base>
-struct destruction_notify_object : Base, shared_secret
+struct embedded_object : Base, shared_secret
 {
-   using Base::Base;
-   ~destruction_notify_object() override { delete_event(); }
+  static_assert(is_embeddable<Base>::value, "embedded_object needs non final base with virtual destructor");
+
+  using Base::Base;
+
+  auto embedded_control_block() noexcept -> control_block_type& override;
+
+  // Memory belongs to embedded_block, unique_ptr deleting this object reports
+  // deletion, when whole object is destroyed, and drops block's self reference.
+  static void operator delete(void *const p) noexcept;
 };
 
+struct deferred_construction {};
+
+template<typename T>
+struct embedded_block
+{
+  using object_type = embedded_object<T>;
+
+  template<typename... Args>
+  explicit embedded_block(Args&&... args)
+    : cb{static_cast<T*>(::new(static_cast<void*>(&storage)) object_type{ std::forward<Args>(args)... }), false, true}
+  {
+    track_created<T>(cb);
+  }
+
+  // address of object is known before it is constructed
+  explicit embedded_block(deferred_construction)
+    : cb{static_cast<T*>(reinterpret_cast<object_type*>(&storage)), false, true}
+  {
+    track_created<T>(cb);
+  }
+
+  // object deleted with its last handle is not reported, nobody can see it
+  ~embedded_block()
+  {
+    deleted(cb).store(true);
+    release_when_not_acquired<T>(cb, embedded_deleter<T>{});
+    track_destroyed(cb);
+  }
+
+  // storage must stay first member, object address is also block address
+  typename std::aligned_storage<sizeof(object_type), alignof(object_type)>::type storage;
+  control_block_type cb;
+};
+
+template<typename Base>
+inline auto embedded_object<Base>::embedded_control_block() noexcept -> control_block_type&
+{
+  return static_cast<embedded_block<Base>*>(static_cast<void*>(this))->cb;
+}
+
+template<typename Base>
+inline void embedded_object<Base>::operator delete(void *const p) noexcept
+{
+  const auto block = static_cast<embedded_block<Base>*>(p);
+  expire_embedded(block->cb);
+  const auto keep_alive = std::move(block->cb.keep_alive);
+}
+
+template<std::size_t... I>
+struct indices {};
+
+template<std::size_t N, std::size_t... I>
+struct make_indices : make_indices<N - 1, N - 1, I...> {};
+
+template<std::size_t... I>
+struct make_indices<0, I...> { using type = indices<I...>; };
+
+// Arguments are stored by value until the first use of object,
+// extras of lazy_constructor are destroyed after control block, which uses them
+template<typename T, typename... Args>
+struct lazy_block : lazy_constructor, embedded_block<T>
+{
+  template<typename... A>
+  explicit lazy_block(A&&... a) : embedded_block<T>(deferred_construction{}), args{std::forward<A>(a)...}
+  {
+    this->cb.extras.store(&extras, std::memory_order_relaxed);
+  }
+
+  // not acquired handle would delete object, which never existed
+  ~lazy_block()
+  {
+    if(!constructed.load(std::memory_order_relaxed))
+      acquired(this->cb).store(true);
+  }
+
+  void create() override
+  {
+    create(typename make_indices<sizeof...(Args)>::type{});
+  }
+
+  template<std::size_t... I>
+  void create(indices<I...>)
+  {
+    using object_type = typename embedded_block<T>::object_type;
+    ::new(static_cast<void*>(&this->storage)) object_type{ std::get<I>(std::move(args))... };
+  }
+
+  std::tuple<Args...> args;
+};
+
+// only embeddable types have embedded_object of their own
+template<typename T>
+inline auto exact_shared_secret(std::true_type, T *const object, const std::type_info& dynamic_type) noexcept -> shared_secret*
+{
+  return dynamic_type == typeid(embedded_object<T>) ? static_cast<embedded_object<T>*>(object) : nullptr;
+}
+
+template<typename T>
+inline auto exact_shared_secret(std::false_type, T *const, const std::type_info&) noexcept -> shared_secret*
+{
+  return nullptr;
+}
+
+// Objects from make_owned are found by exact type, other types by dynamic_cast, which
+// result is remembered for the last dynamic type seen.
+template<typename T>
+inline auto find_shared_secret(T *const p) noexcept -> shared_secret*
+{
+  using type = typename std::remove_cv<T>::type;
+  const auto object = const_cast<type*>(p);
+  const auto& dynamic_type = typeid(*object);
+
+  if(const auto ss = exact_shared_secret(is_embeddable<type>{}, object, dynamic_type))
+    return ss;
+
+  struct cached_cast
+  {
+    const std::type_info* type;
+    std::ptrdiff_t offset;
+    bool found;
+  };
+  static thread_local cached_cast last{nullptr, 0, false};
+
+  if(last.type != &dynamic_type)
+  {
+    const auto ss = dynamic_cast<shared_secret*>(object);
+    last = {&dynamic_type, ss ? reinterpret_cast<char*>(ss) - reinterpret_cast<char*>(object) : 0, ss != nullptr};
+  }
+
+  return last.found ? reinterpret_cast<shared_secret*>(reinterpret_cast<char*>(object) + last.offset) : nullptr;
+}
+
+// Result of dynamic_cast is remembered for the last dynamic type seen. Handle keeps one
+// object address, so cast moving it (to a secondary base) is refused.
+template<typename To, typename From>
+inline auto is_castable(From *const p) noexcept -> bool
+{
+  if(!p)
+    return false;
+
+  struct cached_cast
+  {
+    const std::type_info* type;
+    bool castable;
+  };
+  static thread_local cached_cast last{nullptr, false};
+
+  const auto& dynamic_type = typeid(*p);
+  if(last.type != &dynamic_type)
+  {
+    const auto q = dynamic_cast<To*>(p);
+    last = {&dynamic_type, q && static_cast<const volatile void*>(q) == static_cast<const volatile void*>(p)};
+  }
+
+  return last.castable;
+}
+
 template<typename T>
 class link_ptr
 {
@@ -100,27 +922,333 @@ public:
   link_ptr& operator=(link_ptr&&) = delete;
   link_ptr& operator=(const link_ptr&) = delete;
 
-  auto get() const noexcept -> T* { return ptr; }
+  auto get() const noexcept -> typename std::remove_extent<T>::type* { return ptr; }
+
+private:
+  typename std::remove_extent<T>::type* const ptr;
+};
+
+class scope_region
+{
+public:
+  explicit scope_region(const std::size_t chunk_size) noexcept : chunk_size{chunk_size} {}
+
+  // first chunk fits given number of allocations of the same size as the first one
+  scope_region(const std::size_t chunk_size, const std::size_t batch) noexcept
+    : chunk_size{chunk_size}, batch{batch} {}
+
+  scope_region(const scope_region&) = delete;
+  scope_region& operator=(const scope_region&) = delete;
+
+  ~scope_region()
+  {
+    while(head)
+    {
+      const auto next = head->next;
+      ::operator delete(head);
+      head = next;
+    }
+  }
+
+  void* allocate(std::size_t size, std::size_t alignment)
+  {
+#ifdef OWNED_POINTER_THREAD_SAFE
+    // keep neighbouring control blocks in separate cache lines
+    alignment = alignment > cache_line_size ? alignment : cache_line_size;
+    size = (size + cache_line_size - 1) & ~(cache_line_size - 1);
+#endif
+
+    if(auto p = bump(size, alignment))
+      return p;
+
+    if(!head && batch)
+      add_chunk(batch * ((size + alignment - 1) & ~(alignment - 1)) + alignment);
+    else
+      add_chunk(size + alignment > chunk_size ? size + alignment : chunk_size);
+
+    return bump(size, alignment);
+  }
+
+  void deallocate() noexcept { release(); }
+
+  void acquire() noexcept { users.fetch_add(1, std::memory_order_relaxed); }
+
+  void release() noexcept
+  {
+    if(users.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
 
 private:
-  T* const ptr;
+  struct chunk
+  {
+    chunk* next;
+  };
+
+  void* bump(const std::size_t size, const std::size_t alignment) noexcept
+  {
+    const auto aligned = (current + alignment - 1) & ~(alignment - 1);
+
+    if(!head || aligned + size > end)
+      return nullptr;
+
+    current = aligned + size;
+    acquire();
+
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void add_chunk(const std::size_t size)
+  {
+    const auto c = static_cast<chunk*>(::operator new(sizeof(chunk) + size));
+    c->next = head;
+    head = c;
+
+    current = reinterpret_cast<std::uintptr_t>(c + 1);
+    end = current + size;
+  }
+
+  const std::size_t chunk_size;
+  const std::size_t batch{0};
+  chunk* head{nullptr};
+  std::uintptr_t current{0}, end{0};
+
+  // one for owned_scope and one for every allocation still in use
+  std::atomic<std::size_t> users{1};
 };
 
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * owned_scope serves control blocks from bump region and frees it at once.
+ * Blocks still in use when scope ends keep region until the last one is gone.
+ * Scopes are nested on stack: each one ends on thread, which created it, in reverse
+ * order of creation, so it can't be moved nor copied.
+ *
+ *****************************************************************************************/
+
 template<typename T>
-struct is_expired_enabled :
-  std::integral_constant<bool, std::has_virtual_destructor<T>::value
-                                #if __cplusplus >= 201402L
-                                  && !std::is_final<T>::value
-                                #endif
-                        > {};
+class owned_scope_allocator
+{
+public:
+  using value_type = T;
+
+  explicit owned_scope_allocator(_priv::scope_region *const r) noexcept : region{r} {}
+
+  template<typename U>
+  owned_scope_allocator(const owned_scope_allocator<U>& o) noexcept : region{o.region} {}
+
+  auto allocate(const std::size_t n) -> T*
+  {
+    return static_cast<T*>(region->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, std::size_t) noexcept { region->deallocate(); }
+
+  template<typename U>
+  bool operator==(const owned_scope_allocator<U>& o) const noexcept { return region == o.region; }
+
+  template<typename U>
+  bool operator!=(const owned_scope_allocator<U>& o) const noexcept { return region != o.region; }
+
+private:
+  template<typename>
+  friend class owned_scope_allocator;
+
+  _priv::scope_region* region;
+};
+
+class owned_scope
+{
+public:
+  explicit owned_scope(const std::size_t chunk_size = 64 * 1024)
+    : region{new _priv::scope_region(chunk_size)}, previous{installed()}, owner{std::this_thread::get_id()}
+  {
+    installed() = this;
+  }
+
+  owned_scope(const owned_scope&) = delete;
+  owned_scope(owned_scope&&) = delete;
+  owned_scope& operator=(const owned_scope&) = delete;
+  owned_scope& operator=(owned_scope&&) = delete;
+
+  ~owned_scope()
+  {
+    assert(owner == std::this_thread::get_id() && "ASSERT: owned_scope must end on thread, which created it");
+    assert(installed() == this && "ASSERT: owned_scope must end before scopes created after it");
+    installed() = previous;
+    region->release();
+  }
+
+  static auto current() noexcept -> owned_scope* { return installed(); }
+
+  template<typename T = char>
+  auto get_allocator() const noexcept -> owned_scope_allocator<T>
+  {
+    return owned_scope_allocator<T>{region};
+  }
+
+private:
+  static auto installed() noexcept -> owned_scope*&
+  {
+    static thread_local owned_scope* scope{nullptr};
+    return scope;
+  }
+
+  _priv::scope_region *const region;
+  owned_scope *const previous;
+  const std::thread::id owner;
+};
+
+namespace _priv
+{
+
+// Freed blocks of one type are kept by thread, which frees them, and handed out
+// again by it. Blocks made for mock calls are recycled this way, only blocks kept
+// by test take memory.
+template<typename T>
+class block_pool_allocator
+{
+public:
+  using value_type = T;
+
+  block_pool_allocator() noexcept = default;
+
+  template<typename U>
+  block_pool_allocator(const block_pool_allocator<U>&) noexcept {}
+
+  auto allocate(const std::size_t n) -> T*
+  {
+    if(n != 1)
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+
+    if(closed() || !pool().head)
+      return reinterpret_cast<T*>(::new chunk);
+
+    auto& l = pool();
+    const auto c = l.head;
+    l.head = c->next;
+    l.size--;
+
+    return reinterpret_cast<T*>(c);
+  }
+
+  void deallocate(T *const p, const std::size_t n) noexcept
+  {
+    if(n != 1)
+      return ::operator delete(p);
+
+    const auto c = reinterpret_cast<chunk*>(p);
+    if(closed() || pool().size == capacity)
+      return delete c;
+
+    auto& l = pool();
+    c->next = l.head;
+    l.head = c;
+    l.size++;
+  }
+
+  template<typename U>
+  bool operator==(const block_pool_allocator<U>&) const noexcept { return true; }
+
+  template<typename U>
+  bool operator!=(const block_pool_allocator<U>&) const noexcept { return false; }
+
+private:
+  static constexpr std::size_t capacity = 64;
+
+  union chunk
+  {
+    chunk* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  struct free_list
+  {
+    ~free_list()
+    {
+      closed() = true;
+      while(head)
+      {
+        const auto next = head->next;
+        delete head;
+        head = next;
+      }
+    }
+
+    chunk* head{nullptr};
+    std::size_t size{0};
+  };
+
+  static auto pool() noexcept -> free_list&
+  {
+    static thread_local free_list list;
+    return list;
+  }
+
+  // blocks freed by thread_local objects destroyed after pool go back to heap
+  static auto closed() noexcept -> bool&
+  {
+    static thread_local bool value{false};
+    return value;
+  }
+};
+
+struct scoped_blocks {};
+struct pooled_blocks {};
+
+template<typename Block, typename... Args>
+inline auto make_block(scoped_blocks, Args&&... args) -> std::shared_ptr<Block>
+{
+  if(const auto scope = owned_scope::current())
+    return std::allocate_shared<Block>(scope->get_allocator(), std::forward<Args>(args)...);
+
+  return std::make_shared<Block>(std::forward<Args>(args)...);
+}
+
+template<typename Block, typename... Args>
+inline auto make_block(pooled_blocks, Args&&... args) -> std::shared_ptr<Block>
+{
+  return std::allocate_shared<Block>(block_pool_allocator<Block>{}, std::forward<Args>(args)...);
+}
 
 } // namespace _priv
 
-template<typename Tp>
+/*****************************************************************************************
+ *
+ * borrowed_ptr is raw access view returned by borrow(), expiry is checked once when
+ * it is created. It does not own anything, owned_pointer must outlive it.
+ *
+ *****************************************************************************************/
+
+template<typename T>
+class borrowed_ptr
+{
+public:
+  using element_type = T;
+
+  constexpr explicit borrowed_ptr(T *const p) noexcept : ptr{p} {}
+
+  constexpr auto get() const noexcept -> T* { return ptr; }
+  constexpr auto operator->() const noexcept -> T* { return ptr; }
+  constexpr auto operator*() const noexcept -> T& { return *ptr; }
+  constexpr explicit operator bool() const noexcept { return ptr != nullptr; }
+
+private:
+  T* ptr;
+};
+
+template<typename Tp, typename Deleter>
 class owned_pointer : std::shared_ptr<_priv::control_block_type>
 {
-  static_assert(!std::is_array<Tp>::value && !std::is_pointer<Tp>::value, "no array nor pointer supported");
+  static_assert(!std::is_pointer<Tp>::value, "no pointer supported");
+  static_assert(std::extent<Tp>::value == 0, "no array of known bound supported");
+  static_assert(std::is_same<typename std::unique_ptr<Tp, Deleter>::pointer, typename std::remove_extent<Tp>::type*>::value,
+                "no deleter with custom pointer type supported");
+
   using base_type = std::shared_ptr<_priv::control_block_type>;
+  using block_type = typename _priv::block_of<Tp, Deleter>::type;
 
 #ifdef OWNED_POINTER_STRICT_SAFETY
   static_assert(
@@ -128,13 +1256,16 @@ class owned_pointer : std::shared_ptr<_priv::control_block_type>
       "This type is not strictly safe to use with owned_pointer");
 #endif
 
-  template<typename>
+  template<typename, typename>
   friend class owned_pointer;
 
+  friend struct _priv::owned_access;
+
 public:
-  using element_type = Tp;
+  using element_type = typename std::remove_extent<Tp>::type;
+  using deleter_type = Deleter;
   using base_type::use_count;
-  using uptr_type = std::unique_ptr<element_type>;
+  using uptr_type = std::unique_ptr<Tp, Deleter>;
 
   constexpr owned_pointer() noexcept = default;
   constexpr owned_pointer(std::nullptr_t) noexcept {}
@@ -142,12 +1273,16 @@ public:
   template<typename T>
   owned_pointer(_priv::link_ptr<T>&& p) : owned_pointer(p.get(), true) {}
 
-  template<typename T>
-  owned_pointer(std::unique_ptr<T>&& p) : owned_pointer(p.release(), false) {}
+  template<typename T, typename D, typename = typename std::enable_if<std::is_convertible<D, Deleter>::value, void>::type>
+  owned_pointer(std::unique_ptr<T, D>&& p)
+    : owned_pointer(_priv::scoped_blocks{}, p.release(), false, std::forward<D>(p.get_deleter())) {}
 
   auto get() const -> element_type*;
-  explicit operator uptr_type() const;
-  auto unique_ptr() const -> uptr_type;
+  explicit operator uptr_type() const&;
+  explicit operator uptr_type() &&;
+  auto unique_ptr() const& -> uptr_type;
+  auto unique_ptr() && -> uptr_type;
+  auto shared_ptr() const -> std::shared_ptr<element_type>;
   auto expired() const noexcept -> bool;
   auto raw_ptr() const -> element_type*;
   auto acquired() const noexcept -> bool;
@@ -155,6 +1290,10 @@ public:
   auto operator*() const -> element_type&;
   auto operator->() const -> element_type*;
   auto get(std::nothrow_t) const noexcept -> element_type*;
+  auto borrow() const -> borrowed_ptr<element_type>;
+
+  template<typename X = Tp, typename = typename std::enable_if<std::is_array<X>::value, void>::type>
+  auto operator[](const std::size_t i) const -> element_type& { return get()[i]; }
 
   template<typename X = element_type>
   auto begin() const -> decltype(std::declval<X>().begin()) { return get()->begin(); }
@@ -172,39 +1311,40 @@ public:
   auto size() const -> decltype(std::declval<X>().size()) { return get()->size(); }
   
   template<typename T>
-  operator owned_pointer<T>() const noexcept;
+  operator owned_pointer<T>() const& noexcept;
 
   template<typename T>
-  auto compare(const T& ptr) const noexcept -> std::int8_t;
+  operator owned_pointer<T>() && noexcept;
 
   template<typename T>
-  auto compare(const owned_pointer<T>& p) const noexcept -> std::int8_t;
+  auto compare(const T& ptr) const noexcept -> std::int8_t;
+
+  template<typename T, typename D>
+  auto compare(const owned_pointer<T, D>& p) const noexcept -> std::int8_t;
 
 private:
-  owned_pointer(element_type *const p, const bool acquired);
+  owned_pointer(element_type *const p, const bool acquired)
+    : owned_pointer(_priv::scoped_blocks{}, p, acquired, Deleter()) {}
+
+  template<typename Blocks, typename D>
+  owned_pointer(Blocks, element_type *const p, const bool acquired, D&& d);
+  explicit owned_pointer(base_type&& cb) noexcept : base_type(std::move(cb)) {}
 
   auto stored_address() const noexcept -> element_type*;
+  void construct_when_lazy() const;
   void throw_when_ptr_expired_and_object_has_virtual_dtor() const;
 
-  template<typename T, typename = typename std::enable_if<std::is_polymorphic<T>::value, void>::type>
-  auto get_secret_when_possible(T *const p) noexcept -> _priv::shared_secret*
-  {
-    if(auto ss{dynamic_cast<_priv::shared_secret*>(p)})
-      return base_type::operator=(ss->control_block.lock()), ss;
-
-    return nullptr;
-  }
-
-  auto get_secret_when_possible(...) noexcept -> _priv::shared_secret*
+  // objects from make_owned are shared only by pointers to single object with default deleter,
+  // block of object handed out by unique_ptr() is held by its keep_alive
+  template<typename T, typename = typename std::enable_if<std::is_polymorphic<T>::value &&
+                                                          std::is_same<block_type, _priv::separate_block<T>>::value, void>::type>
+  void share_embedded_block_when_possible(T *const p) noexcept
   {
-    return nullptr;
+    if(const auto ss = _priv::find_shared_secret(p))
+      base_type::operator=(ss->embedded_control_block().keep_alive);
   }
 
-  void set_shared_secret_when_possible(_priv::shared_secret *const ss) const
-  {
-    if(ss != nullptr)
-      ss->control_block = *this;
-  }
+  void share_embedded_block_when_possible(...) noexcept {}
 };
 
 template<>
@@ -212,8 +1352,8 @@ struct owned_pointer<void>
 {};
 
 #if __cplusplus >= 201703L
-template<typename T>
-owned_pointer(std::unique_ptr<T>&&) -> owned_pointer<T>;
+template<typename T, typename D>
+owned_pointer(std::unique_ptr<T, D>&&) -> owned_pointer<T, D>;
 
 template<typename T>
 owned_pointer(_priv::link_ptr<T>&&) -> owned_pointer<T>;
@@ -235,102 +1375,186 @@ struct ptr_is_already_deleted : public std::runtime_error
   ptr_is_already_deleted() : std::runtime_error("owned_pointer: This pointer is already deleted") {}
 };
 
+struct ptr_is_already_observed : public std::runtime_error
+{
+  ptr_is_already_observed() : std::runtime_error("owned_pointer: This pointer is already in other container") {}
+};
+
 /*****************************************************************************************
  *
  * Public member class functions
  *
  *****************************************************************************************/
 
-template<typename T>
-inline auto owned_pointer<T>::get() const -> element_type*
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::get() const -> element_type*
 {
+#ifndef OWNED_POINTER_UNCHECKED_ACCESS
   throw_when_ptr_expired_and_object_has_virtual_dtor();
+#endif
+  construct_when_lazy();
   return stored_address();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::operator->() const -> element_type*
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::operator->() const -> element_type*
 {
   return get();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::operator*() const -> element_type&
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::operator*() const -> element_type&
 {
   return *get();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::unique_ptr() const -> uptr_type
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::unique_ptr() const& -> uptr_type
 {
-  if(!get())
+  throw_when_ptr_expired_and_object_has_virtual_dtor();
+  construct_when_lazy();
+
+  if(!stored_address())
     return uptr_type { nullptr };
 
-  if(acquired())
+  if(!_priv::try_acquire(*this))
     throw unique_ptr_already_acquired();
 
-  return _priv::acquired(base_type::operator*()) = true, uptr_type{stored_address()};
+  return uptr_type{stored_address(), block_type::deleter(base_type::operator*())};
 }
 
-template<typename T>
-inline auto owned_pointer<T>::raw_ptr() const -> element_type*
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::unique_ptr() && -> uptr_type
+{
+  throw_when_ptr_expired_and_object_has_virtual_dtor();
+  construct_when_lazy();
+
+  const auto p = stored_address();
+  if(!p)
+    return uptr_type { nullptr };
+
+  // separate block may die in try_acquire, so its deleter is taken before
+  D d = block_type::deleter(base_type::operator*());
+  if(!_priv::try_acquire(static_cast<base_type&&>(*this)))
+    throw unique_ptr_already_acquired();
+
+  return uptr_type{p, std::forward<D>(d)};
+}
+
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::shared_ptr() const -> std::shared_ptr<element_type>
+{
+  throw_when_ptr_expired_and_object_has_virtual_dtor();
+  construct_when_lazy();
+
+  const auto p = stored_address();
+  if(!p)
+    return nullptr;
+
+  if(!_priv::try_share(base_type::operator*()))
+    throw unique_ptr_already_acquired();
+
+  return std::shared_ptr<element_type>{ static_cast<const base_type&>(*this), p };
+}
+
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::raw_ptr() const -> element_type*
 {
   return unique_ptr().release();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::acquired() const noexcept -> bool
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::acquired() const noexcept -> bool
 {
-  return base_type::operator bool() && _priv::acquired(base_type::operator*());
+  return base_type::operator bool() && _priv::acquired(base_type::operator*()).load();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::expired() const noexcept -> bool
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::expired() const noexcept -> bool
 {
-  return base_type::operator bool() && _priv::deleted(base_type::operator*());
+  return base_type::operator bool() && _priv::deleted(base_type::operator*()).load();
 }
 
-template<typename T>
-inline owned_pointer<T>::operator uptr_type() const
+template<typename T, typename D>
+inline owned_pointer<T, D>::operator uptr_type() const&
 {
   return unique_ptr();
 }
 
-template<typename T>
-inline owned_pointer<T>::operator bool() const noexcept
+template<typename T, typename D>
+inline owned_pointer<T, D>::operator uptr_type() &&
+{
+  return std::move(*this).unique_ptr();
+}
+
+template<typename T, typename D>
+inline owned_pointer<T, D>::operator bool() const noexcept
 {
   return stored_address();
 }
 
-template<typename T>
-inline auto owned_pointer<T>::get(std::nothrow_t) const noexcept -> element_type*
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::get(std::nothrow_t) const noexcept -> element_type*
+{
+  if(expired())
+    return nullptr;
+
+  try
+  {
+    construct_when_lazy();
+  }
+  catch(...)
+  {
+    return nullptr;
+  }
+
+  return stored_address();
+}
+
+template<typename T, typename D>
+inline auto owned_pointer<T, D>::borrow() const -> borrowed_ptr<element_type>
+{
+  throw_when_ptr_expired_and_object_has_virtual_dtor();
+  construct_when_lazy();
+  return borrowed_ptr<element_type>{stored_address()};
+}
+
+template<typename R, typename D> template<typename T>
+inline owned_pointer<R, D>::operator owned_pointer<T>() const& noexcept
 {
-  return expired() ? nullptr : stored_address();
+  static_assert(std::is_convertible<element_type*, T*>::value,
+                "Casting to pointer of different or non-derived type");
+  static_assert(std::is_same<block_type, _priv::separate_block<R>>::value,
+                "Casting only possible for pointer to single object with default deleter");
+
+  return owned_pointer<T>{ base_type{*this} };
 }
 
-template<typename R> template<typename T>
-inline owned_pointer<R>::operator owned_pointer<T>() const noexcept
+template<typename R, typename D> template<typename T>
+inline owned_pointer<R, D>::operator owned_pointer<T>() && noexcept
 {
   static_assert(std::is_convertible<element_type*, T*>::value,
                 "Casting to pointer of different or non-derived type");
+  static_assert(std::is_same<block_type, _priv::separate_block<R>>::value,
+                "Casting only possible for pointer to single object with default deleter");
 
-  owned_pointer<T> casted{nullptr};
-  return(static_cast<base_type&>(casted) = *this, casted);
+  return owned_pointer<T>{ static_cast<base_type&&>(*this) };
 }
 
-template<typename R> template<typename T>
-inline auto owned_pointer<R>::compare(const T& ptr) const noexcept -> std::int8_t
+template<typename R, typename D> template<typename T>
+inline auto owned_pointer<R, D>::compare(const T& ptr) const noexcept -> std::int8_t
 {
   static_assert(std::is_convertible<T, element_type*>::value ||
                 std::is_convertible<element_type*, T>::value,
                 "Comparing pointer of different or non-derived type");
 
-  const auto addr{stored_address()};
-  return addr == ptr ? 0 : (addr < ptr ? -1 : +1);
+  const void* const addr{stored_address()};
+  const void* const other{ptr};
+  return addr == other ? 0 : (std::less<const void*>()(addr, other) ? -1 : +1);
 }
 
-template<typename R> template<typename T>
-inline auto owned_pointer<R>::compare(const owned_pointer<T>& p) const noexcept -> std::int8_t
+template<typename R, typename D> template<typename T, typename E>
+inline auto owned_pointer<R, D>::compare(const owned_pointer<T, E>& p) const noexcept -> std::int8_t
 {
   return compare(p.stored_address());
 }
@@ -340,35 +1564,46 @@ inline auto owned_pointer<R>::compare(const owned_pointer<T>& p) const noexcept
  *
  *****************************************************************************************/
 
-template<typename T>
-auto owned_pointer<T>::stored_address() const noexcept -> element_type*
+template<typename T, typename D>
+auto owned_pointer<T, D>::stored_address() const noexcept -> element_type*
 {
   return base_type::operator bool() ?
        static_cast<element_type*>(_priv::ptr(base_type::operator*())) : nullptr;
 }
 
-template<typename T>
-void owned_pointer<T>::throw_when_ptr_expired_and_object_has_virtual_dtor() const
+template<typename T, typename D>
+void owned_pointer<T, D>::construct_when_lazy() const
+{
+  // lazy object derives from its type, handle of non class type skips the check
+  if(!std::is_class<element_type>::value)
+    return;
+
+  if(!base_type::operator bool())
+    return;
+
+  if(const auto e = _priv::extras_of(base_type::operator*()))
+    if(e->lazy) e->lazy->construct();
+}
+
+template<typename T, typename D>
+void owned_pointer<T, D>::throw_when_ptr_expired_and_object_has_virtual_dtor() const
 {
   if(expired())
     throw ptr_is_already_deleted();
 }
 
-template<typename T>
-owned_pointer<T>::owned_pointer(element_type *const p, const bool acquired)
+template<typename T, typename D> template<typename Blocks, typename E>
+owned_pointer<T, D>::owned_pointer(Blocks, element_type *const p, const bool acquired, E&& d)
 {
   if(!p) return;
-  const auto ss = get_secret_when_possible(p);
+  share_embedded_block_when_possible(p);
 
   if(!base_type::operator bool())
   {
-    base_type::reset(
-      new _priv::control_block_type(p, {}, {}),
-      _priv::owned_deleter<element_type>()
-    );
-    set_shared_secret_when_possible(ss);
+    const auto block = _priv::make_block<block_type>(Blocks{}, p, acquired, std::forward<E>(d));
+    base_type::operator=(base_type(block, &block->cb));
   }
-  _priv::acquired(base_type::operator*()) = acquired;
+  _priv::set_acquired(*this, acquired);
 }
 
 /*****************************************************************************************
@@ -403,10 +1638,105 @@ template<typename T>
 constexpr bool is_expired_enabled_v{is_expired_enabled<T>::value};
 #endif
 
+namespace _priv
+{
+
+struct owned_access
+{
+  template<typename T, typename D>
+  static auto notifies_destruction(const owned_pointer<T, D>& p) noexcept -> bool
+  {
+    using watched = std::integral_constant<bool, is_watched<T>::value && std::is_same<D, std::default_delete<T>>::value>;
+    return p.base_type::operator bool() && (p.base_type::operator*().embedded || watched::value);
+  }
+
+  template<typename T, typename D>
+  static auto block(const owned_pointer<T, D>& p) noexcept -> control_block_type*
+  {
+    return p.base_type::get();
+  }
+
+  template<typename T, typename D>
+  static auto address(const owned_pointer<T, D>& p) noexcept -> typename owned_pointer<T, D>::element_type*
+  {
+    return p.stored_address();
+  }
+
+  // address of living object, nullptr also for lazy object which is not constructed yet
+  template<typename T, typename D>
+  static auto living_address(const owned_pointer<T, D>& p) noexcept -> typename owned_pointer<T, D>::element_type*
+  {
+    if(!p.base_type::operator bool() || p.expired())
+      return nullptr;
+
+    const auto e = extras_of(p.base_type::operator*());
+    return e && e->lazy && !e->lazy->is_constructed() ? nullptr : p.stored_address();
+  }
+
+  // owned_pointer made from unique_ptr passed to mock, it takes control block from pool
+  template<typename T, typename D>
+  static auto forward(std::unique_ptr<T, D>& u) -> owned_pointer<T, D>
+  {
+    return owned_pointer<T, D>{ pooled_blocks{}, u.release(), false, std::forward<D>(u.get_deleter()) };
+  }
+
+  template<typename To, typename From>
+  static auto rebind(owned_pointer<From>&& p) noexcept -> owned_pointer<To>
+  {
+    return owned_pointer<To>{ static_cast<typename owned_pointer<From>::base_type&&>(p) };
+  }
+
+  template<typename To, typename From>
+  static auto rebind(const owned_pointer<From>& p) noexcept -> owned_pointer<To>
+  {
+    return owned_pointer<To>{ typename owned_pointer<From>::base_type{p} };
+  }
+
+  template<typename Object, typename Alloc, typename... Args>
+  static auto make(std::true_type, const Alloc& alloc, Args&&... args) -> owned_pointer<Object>
+  {
+    const auto block = std::allocate_shared<embedded_block<Object>>(alloc, std::forward<Args>(args)...);
+    return owned_pointer<Object>{ std::shared_ptr<control_block_type>(block, &block->cb) };
+  }
+
+  template<typename Object, typename Alloc, typename... Args>
+  static auto make_lazy(const Alloc& alloc, Args&&... args) -> owned_pointer<Object>
+  {
+    using block_type = lazy_block<Object, typename std::decay<Args>::type...>;
+    const auto block = std::allocate_shared<block_type>(alloc, std::forward<Args>(args)...);
+
+    return owned_pointer<Object>{ std::shared_ptr<control_block_type>(block, &block->cb) };
+  }
+
+  template<typename Object, typename Alloc, typename... Args>
+  static auto make(std::false_type, const Alloc& alloc, Args&&... args) -> owned_pointer<Object>
+  {
+    std::unique_ptr<Object> object{ new Object{ std::forward<Args>(args)... } };
+    const auto block = std::allocate_shared<separate_block<Object>>(alloc, object.get(), false);
+
+    return object.release(), owned_pointer<Object>{ std::shared_ptr<control_block_type>(block, &block->cb) };
+  }
+};
+
+template<typename Alloc, typename = typename std::enable_if<!std::is_pointer<Alloc>::value, void>::type>
+inline auto as_allocator(const Alloc& alloc) noexcept -> const Alloc&
+{
+  return alloc;
+}
+
+#if OWNED_POINTER_HAS_PMR
+inline auto as_allocator(std::pmr::memory_resource *const resource) noexcept -> std::pmr::polymorphic_allocator<char>
+{
+  return std::pmr::polymorphic_allocator<char>{resource};
+}
+#endif
+
+} // namespace _priv
+
 template<typename T, typename = typename std::enable_if<_priv::is_expired_enabled<T>::value, void>::type>
 inline bool is_expired_enabled_f(const owned_pointer<T>& p) noexcept
 {
-  return p.expired() || nullptr != dynamic_cast<_priv::shared_secret*>(p.operator->());
+  return p.expired() || _priv::owned_access::notifies_destruction(p);
 }
 
 template<typename T>
@@ -415,17 +1745,143 @@ inline bool is_expired_enabled_f(const T&) noexcept
   return false;
 }
 
+template<typename Object, typename Alloc, typename... Args>
+inline auto allocate_owned(const Alloc& alloc, Args&&... args) -> owned_pointer<Object>
+{
+  return _priv::owned_access::make<Object>(
+            _priv::is_embeddable<Object>{}, _priv::as_allocator(alloc), std::forward<Args>(args)...);
+}
+
+template<typename Object, typename... Args>
+inline auto make_owned(Args&&... args) -> typename std::enable_if<!std::is_array<Object>::value, owned_pointer<Object>>::type
+{
+  if(const auto scope = owned_scope::current())
+    return allocate_owned<Object>(scope->get_allocator(), std::forward<Args>(args)...);
+
+  return allocate_owned<Object>(std::allocator<char>(), std::forward<Args>(args)...);
+}
+
+// Object is constructed by the first get(), operator->, unique_ptr() or shared_ptr()
+template<typename Object, typename... Args>
+inline auto make_owned_lazy(Args&&... args) -> owned_pointer<Object>
+{
+  static_assert(_priv::is_embeddable<Object>::value,
+                "Lazy construction only possible for non final object with virtual destructor");
+
+  if(const auto scope = owned_scope::current())
+    return _priv::owned_access::make_lazy<Object>(scope->get_allocator(), std::forward<Args>(args)...);
+
+  return _priv::owned_access::make_lazy<Object>(std::allocator<char>(), std::forward<Args>(args)...);
+}
+
+// Array elements are value initialized, like with std::make_unique<T[]>(n)
+template<typename Object>
+inline auto make_owned(const std::size_t n) -> typename std::enable_if<std::is_array<Object>::value && std::extent<Object>::value == 0,
+                                                                        owned_pointer<Object>>::type
+{
+  return owned_pointer<Object>{ std::unique_ptr<Object>{ new typename std::remove_extent<Object>::type[n]() } };
+}
+
 template<typename Object, typename... Args>
-inline auto make_owned(Args&&... args) -> owned_pointer<Object>
+inline auto make_owned_n(const std::size_t n, const Args&... args) -> std::vector<owned_pointer<Object>>
+{
+  std::vector<owned_pointer<Object>> objects;
+  objects.reserve(n);
+
+  // region is released when all blocks and this function are done with it
+  const auto region = new _priv::scope_region(64 * 1024, n);
+  try
+  {
+    for(std::size_t i = 0; i < n; i++)
+      objects.push_back(allocate_owned<Object>(owned_scope_allocator<char>{region}, args...));
+  }
+  catch(...)
+  {
+    objects.clear();
+    region->release();
+    throw;
+  }
+
+  region->release();
+  return objects;
+}
+
+namespace _priv
+{
+
+// allocate_shared puts its reference counts and vptr in front of block
+template<typename T>
+inline auto graph_allocation_size() noexcept -> std::size_t
+{
+  using block_type = typename std::conditional<is_embeddable<T>::value, embedded_block<T>, separate_block<T>>::type;
+  const std::size_t size = sizeof(block_type) + 4 * sizeof(void*) + alignof(block_type);
+
+#ifdef OWNED_POINTER_THREAD_SAFE
+  return ((size + cache_line_size - 1) & ~(cache_line_size - 1)) + cache_line_size;
+#else
+  return size;
+#endif
+}
+
+template<typename Object, typename Alloc, typename Tuple, std::size_t... I>
+inline auto allocate_owned_from(const Alloc& alloc, Tuple&& args, indices<I...>) -> owned_pointer<Object>
+{
+  return allocate_owned<Object>(alloc, std::get<I>(std::forward<Tuple>(args))...);
+}
+
+template<typename Object, typename Alloc, typename Tuple>
+inline auto allocate_owned_from(const Alloc& alloc, Tuple&& args) -> owned_pointer<Object>
+{
+  using size = std::tuple_size<typename std::decay<Tuple>::type>;
+  return allocate_owned_from<Object>(alloc, std::forward<Tuple>(args), typename make_indices<size::value>::type{});
+}
+
+template<typename>
+using no_arguments = std::tuple<>;
+
+template<typename... Objects, typename... Tuples>
+inline auto make_owned_graph(Tuples&&... args) -> std::tuple<owned_pointer<Objects>...>
+{
+  static_assert(sizeof...(Tuples) == sizeof...(Objects), "Tuple of arguments required for every object");
+
+  const std::size_t sizes[] = { 0, graph_allocation_size<Objects>()... };
+  std::size_t size = 0;
+  for(const auto s : sizes)
+    size += s;
+
+  // region is released when all blocks and this function are done with it
+  const auto region = new scope_region(size);
+  try
+  {
+    // braced list constructs elements in order
+    std::tuple<owned_pointer<Objects>...> objects{
+      allocate_owned_from<Objects>(owned_scope_allocator<char>{region}, std::forward<Tuples>(args))... };
+
+    region->release();
+    return objects;
+  }
+  catch(...)
+  {
+    region->release();
+    throw;
+  }
+}
+
+} // namespace _priv
+
+// Blocks (and objects, if they are expired enabled) are placed in one region, but every
+// element can be acquired and deleted separately. Every object gets tuple of its
+// constructor arguments.
+template<typename... Objects, typename... Tuples>
+inline auto make_owned_graph(Tuples&&... args) -> std::tuple<owned_pointer<Objects>...>
 {
-  using C = std::conditional<
-               _priv::is_expired_enabled<Object>::value,
-               _priv::destruction_notify_object<Object> ,
-               Object
-            >;
+  return _priv::make_owned_graph<Objects...>(std::forward<Tuples>(args)...);
+}
 
-  return std::unique_ptr<Object>(
-                  new typename C::type{ std::forward<Args>(args)... });
+template<typename... Objects>
+inline auto make_owned_graph() -> std::tuple<owned_pointer<Objects>...>
+{
+  return _priv::make_owned_graph<Objects...>(_priv::no_arguments<Objects>{}...);
 }
 
 template<typename T>
@@ -446,134 +1902,252 @@ inline auto static_pointer_cast(const owned_pointer<From>& from) noexcept -> own
   return { from };
 }
 
+template<typename To, typename From>
+inline auto static_pointer_cast(owned_pointer<From>&& from) noexcept -> owned_pointer<To>
+{
+  return std::move(from).template operator owned_pointer<To>();
+}
+
+template<typename T, typename F>
+inline auto dynamic_pointer_cast(owned_pointer<F>&& from) noexcept -> owned_pointer<T>
+{
+  static_assert(_priv::is_embeddable<F>::value, "Only possible for polymorphic types");
+
+  if(_priv::is_castable<T>(from.get(std::nothrow)))
+    return _priv::owned_access::rebind<T>(std::move(from));
+
+  return nullptr;
+}
+
 template<typename T, typename F>
 inline auto dynamic_pointer_cast(const owned_pointer<F>& from) noexcept -> owned_pointer<T>
 {
-  static_assert(is_expired_enabled<decltype(from)>::value, "Only possible for polymorphic types");
+  static_assert(_priv::is_embeddable<F>::value, "Only possible for polymorphic types");
 
-  if (!from.expired())
-  {
-    if (auto p = dynamic_cast<T*>( from.operator->() ))
-    {
-      return std::unique_ptr<T>{p};
-    }
-  }
+  if(_priv::is_castable<T>(from.get(std::nothrow)))
+    return _priv::owned_access::rebind<T>(from);
 
   return nullptr;
 }
 
+/*****************************************************************************************
+ *
+ * Live object registry, filled only with define OWNED_POINTER_REGISTRY. Queries must
+ * not race with destruction of objects, they are meant for end of test.
+ *
+ *****************************************************************************************/
+
+template<typename Predicate>
+inline auto live_objects(Predicate pred) -> std::vector<live_object>
+{
+  std::vector<live_object> objects;
+#ifdef OWNED_POINTER_REGISTRY
+  _priv::live_blocks().for_each([&](_priv::control_block_type& cb) {
+    const live_object o{ cb.object, cb.type_name, cb.site, cb.acquired.load(), cb.deleted.load() };
+    if(pred(cb, o)) objects.push_back(o);
+  });
+#else
+  (void)pred;
+#endif
+  return objects;
+}
+
+inline auto live_objects() -> std::vector<live_object>
+{
+  return live_objects([](const _priv::control_block_type&, const live_object&) { return true; });
+}
+
+// Objects created by make_owned since mark, which were handed out by unique_ptr()
+// and never deleted. Object of other types can't report their deletion.
+inline auto leaked_objects(const std::uint64_t mark) -> std::vector<live_object>
+{
+  return live_objects([mark](const _priv::control_block_type& cb, const live_object& o) {
+#ifdef OWNED_POINTER_REGISTRY
+    return cb.embedded && cb.serial >= mark && o.acquired && !o.deleted;
+#else
+    return (void)cb, (void)o, (void)mark, false;
+#endif
+  });
+}
+
 /*****************************************************************************************
  *
  * Public compare operators
  *
  *****************************************************************************************/
 
-template<typename A>
-inline bool operator==(const owned_pointer<A>& p1, std::nullptr_t) noexcept
+template<typename A, typename DA>
+inline bool operator==(const owned_pointer<A, DA>& p1, std::nullptr_t) noexcept
 {
   return p1.compare(nullptr) == 0;
 }
 
-template<typename A>
-inline bool operator!=(const owned_pointer<A>& p1, std::nullptr_t) noexcept
+template<typename A, typename DA>
+inline bool operator!=(const owned_pointer<A, DA>& p1, std::nullptr_t) noexcept
 {
   return p1.compare(nullptr) != 0;
 }
 
-template<typename A>
-inline bool operator==(std::nullptr_t, const owned_pointer<A>& p1) noexcept
+template<typename A, typename DA>
+inline bool operator==(std::nullptr_t, const owned_pointer<A, DA>& p1) noexcept
 {
   return p1 == nullptr;
 }
 
-template<typename A>
-inline bool operator!=(std::nullptr_t, const owned_pointer<A>& p1) noexcept
+template<typename A, typename DA>
+inline bool operator!=(std::nullptr_t, const owned_pointer<A, DA>& p1) noexcept
 {
   return p1 != nullptr;
 }
 
-template<typename A, typename B>
-inline bool operator==(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator==(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p1.compare(p2) == 0;
 }
 
-template<typename A, typename B>
-inline bool operator!=(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator!=(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return !(p1 == p2);
 }
 
-template<typename A, typename B>
-inline bool operator<(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator<(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p1.compare(p2) < 0;
 }
 
-template<typename A, typename B>
-inline bool operator<=(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator<=(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p1.compare(p2) <= 0;
 }
 
-template<typename A, typename B>
-inline bool operator>(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator>(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p1.compare(p2) > 0;
 }
 
-template<typename A, typename B>
-inline bool operator>=(const owned_pointer<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator>=(const owned_pointer<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p1.compare(p2) >= 0;
 }
 
-template<typename A, typename B>
-inline bool operator==(const owned_pointer<A>& p1, const B* p2) noexcept
+template<typename A, typename DA, typename B>
+inline bool operator==(const owned_pointer<A, DA>& p1, const B* p2) noexcept
 {
   return p1.compare(p2) == 0;
 }
 
-template<typename A, typename B>
-inline bool operator==(const A* p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename B, typename DB>
+inline bool operator==(const A* p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p2.compare(p1) == 0;
 }
 
-template<typename A, typename B>
-inline bool operator!=(const owned_pointer<A>& p1, const B* p2) noexcept
+template<typename A, typename DA, typename B>
+inline bool operator!=(const owned_pointer<A, DA>& p1, const B* p2) noexcept
 {
   return p1.compare(p2) != 0;
 }
 
-template<typename A, typename B>
-inline bool operator!=(const A* p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename B, typename DB>
+inline bool operator!=(const A* p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p2.compare(p1) != 0;
 }
 
-template<typename A, typename B>
-inline bool operator==(const owned_pointer<A>& p1, const std::unique_ptr<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator==(const owned_pointer<A, DA>& p1, const std::unique_ptr<B, DB>& p2) noexcept
 {
   return p1.compare(p2.get()) == 0;
 }
 
-template<typename A, typename B>
-inline bool operator==(const std::unique_ptr<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator==(const std::unique_ptr<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p2.compare(p1.get()) == 0;
 }
 
-template<typename A, typename B>
-inline bool operator!=(const owned_pointer<A>& p1, const std::unique_ptr<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator!=(const owned_pointer<A, DA>& p1, const std::unique_ptr<B, DB>& p2) noexcept
 {
   return p1.compare(p2.get()) != 0;
 }
 
-template<typename A, typename B>
-inline bool operator!=(const std::unique_ptr<A>& p1, const owned_pointer<B>& p2) noexcept
+template<typename A, typename DA, typename B, typename DB>
+inline bool operator!=(const std::unique_ptr<A, DA>& p1, const owned_pointer<B, DB>& p2) noexcept
 {
   return p2.compare(p1.get()) != 0;
 }
 
+/*****************************************************************************************
+ *
+ * Hashing by stored address, it never checks expiry. owned_hash and owned_equal are
+ * transparent, so owned_pointer keys can be found by raw pointer or std::unique_ptr.
+ *
+ *****************************************************************************************/
+
+namespace _priv
+{
+
+template<typename T, typename D>
+inline auto address_of(const owned_pointer<T, D>& p) noexcept -> const void*
+{
+  return owned_access::address(p);
+}
+
+template<typename T, typename D>
+inline auto address_of(const std::unique_ptr<T, D>& p) noexcept -> const void*
+{
+  return p.get();
+}
+
+template<typename T>
+inline auto address_of(T *const p) noexcept -> const void*
+{
+  return p;
+}
+
+} // namespace _priv
+
+struct owned_hash
+{
+  using is_transparent = void;
+
+  template<typename P>
+  auto operator()(const P& p) const noexcept -> std::size_t
+  {
+    return std::hash<const void*>()(_priv::address_of(p));
+  }
+};
+
+struct owned_equal
+{
+  using is_transparent = void;
+
+  template<typename A, typename B>
+  auto operator()(const A& a, const B& b) const noexcept -> bool
+  {
+    return _priv::address_of(a) == _priv::address_of(b);
+  }
+};
+
 } //namespace csp
+
+namespace std
+{
+
+template<typename T, typename D>
+struct hash<csp::owned_pointer<T, D>>
+{
+  auto operator()(const csp::owned_pointer<T, D>& p) const noexcept -> std::size_t
+  {
+    return csp::owned_hash()(p);
+  }
+};
+
+} // namespace std
@@ -0,0 +1,168 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+
+// Class scoped operator delete, which reports deletion of object to owned_pointers
+// pointing to it. It adds no vtable nor data member, put it in class body:
+//
+//   struct money final
+//   {
+//     OWNED_POINTER_TRACK_DELETE()
+//     long cents;
+//   };
+#define OWNED_POINTER_TRACK_DELETE()                                   \
+  using owned_pointer_track_delete = void;                             \
+  static void operator delete(void *const p) noexcept                  \
+  {                                                                    \
+    ::csp::notify_deleted(p);                                          \
+    ::operator delete(p);                                              \
+  }
+
+namespace csp
+{
+
+namespace _priv
+{
+
+template<typename T, typename = void>
+struct has_track_delete : std::false_type {};
+
+template<typename T>
+struct has_track_delete<T, typename T::owned_pointer_track_delete> : std::true_type {};
+
+/*****************************************************************************************
+ *
+ * Objects, which can't have destruction notifier derived from them, are found by
+ * address in table split in shards with own mutex. Control block leaves table under
+ * lock of its shard, so deletion in one thread can't report to block dying in other.
+ *
+ *****************************************************************************************/
+
+class deletion_table
+{
+public:
+  // Expire runs under lock of shard and leaves pending work, like user callbacks,
+  // which may destroy watched blocks, to flush running after the lock is released.
+  using expire_type = void (*)(void* block, void*& pending);
+  using flush_type = void (*)(void* pending);
+
+  // block is just not watched, when entry could not be allocated
+  void watch(const void *const object, void *const block, const expire_type expire, const flush_type flush) noexcept
+  {
+    auto& s = shard_of(object);
+    const std::lock_guard<std::mutex> lock{s.mutex};
+    try
+    {
+      s.entries.emplace(object, entry{block, expire, flush});
+    }
+    catch(...)
+    {}
+  }
+
+  void unwatch(const void *const object, const void *const block) noexcept
+  {
+    auto& s = shard_of(object);
+    const std::lock_guard<std::mutex> lock{s.mutex};
+    const auto range = s.entries.equal_range(object);
+
+    for(auto i = range.first; i != range.second; ++i)
+      if(i->second.block == block) { s.entries.erase(i); return; }
+  }
+
+  void deleted(const void *const object) noexcept
+  {
+    void* pending{nullptr};
+    flush_type flush{nullptr};
+    {
+      auto& s = shard_of(object);
+      const std::lock_guard<std::mutex> lock{s.mutex};
+      const auto range = s.entries.equal_range(object);
+
+      for(auto i = range.first; i != range.second; ++i)
+        i->second.expire(i->second.block, pending), flush = i->second.flush;
+
+      s.entries.erase(range.first, range.second);
+    }
+
+    if(flush) flush(pending);
+  }
+
+private:
+  static constexpr std::size_t shards = 16;
+
+  struct entry
+  {
+    void* block;
+    expire_type expire;
+    flush_type flush;
+  };
+
+  struct alignas(64) shard
+  {
+    std::mutex mutex;
+    std::unordered_multimap<const void*, entry> entries;
+  };
+
+  auto shard_of(const void *const object) noexcept -> shard&
+  {
+    return table[(reinterpret_cast<std::uintptr_t>(object) >> 4) % shards];
+  }
+
+  shard table[shards];
+};
+
+// never destroyed, static owned_pointers may leave it after exit of main
+inline auto deleted_objects() noexcept -> deletion_table&
+{
+  alignas(deletion_table) static char storage[sizeof(deletion_table)];
+  static deletion_table *const table{::new(static_cast<void*>(storage)) deletion_table};
+  return *table;
+}
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * Deletion of type T is tracked and owned_pointer<T> can tell it is expired, when T has
+ * OWNED_POINTER_TRACK_DELETE() or when this trait is specialized and T reports its
+ * deletion with notify_deleted(this) itself.
+ *
+ *****************************************************************************************/
+
+template<typename T>
+struct track_deletion : _priv::has_track_delete<T> {};
+
+inline void notify_deleted(const void *const object) noexcept
+{
+  _priv::deleted_objects().deleted(object);
+}
+
+} // namespace csp
@@ -0,0 +1,206 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <utility>
+#include <type_traits>
+#include "owned_pointer.hpp"
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine) && defined(__has_include)
+#  if __has_include(<coroutine>)
+#    include <coroutine>
+#    define OWNED_POINTER_HAS_COROUTINES 1
+#  endif
+#endif
+
+#ifndef OWNED_POINTER_HAS_COROUTINES
+#  define OWNED_POINTER_HAS_COROUTINES 0
+#endif
+
+namespace csp
+{
+
+namespace _priv
+{
+
+template<typename F>
+class callback_listener final : public expiry_listener
+{
+public:
+  explicit callback_listener(F f) : callback(std::move(f)) {}
+
+  void expired() noexcept override { callback(), delete this; }
+  void dropped() noexcept override { delete this; }
+
+private:
+  F callback;
+};
+
+class promise_listener final : public expiry_listener
+{
+public:
+  auto get_future() -> std::future<void> { return promise.get_future(); }
+
+  void expired() noexcept override
+  {
+    try { promise.set_value(); } catch(...) {}
+    delete this;
+  }
+
+  // future gets std::future_errc::broken_promise
+  void dropped() noexcept override { delete this; }
+
+private:
+  std::promise<void> promise;
+};
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * Notifications about deletion of object, for types which are expired enabled. They are
+ * run by thread deleting object, when destructor of object is done, and must not throw.
+ * If object is already deleted, notification runs at once in calling thread.
+ *
+ *****************************************************************************************/
+
+template<typename T, typename D, typename F>
+inline void on_expired(const owned_pointer<T, D>& p, F&& f)
+{
+  static_assert(_priv::is_expired_enabled<T>::value, "Deletion of this type is never reported");
+
+  const auto cb = _priv::owned_access::block(p);
+  if(!cb) return;
+
+  const auto l = new _priv::callback_listener<typename std::decay<F>::type>(std::forward<F>(f));
+  if(!_priv::add_listener(*cb, l))
+    l->expired();
+}
+
+// Future is ready when object is deleted, it gets broken_promise if last owned_pointer
+// is gone first.
+template<typename T, typename D>
+inline auto expiry_future(const owned_pointer<T, D>& p) -> std::future<void>
+{
+  static_assert(_priv::is_expired_enabled<T>::value, "Deletion of this type is never reported");
+
+  const auto l = new _priv::promise_listener;
+  auto f = l->get_future();
+  const auto cb = _priv::owned_access::block(p);
+
+  if(!cb)
+    l->dropped();
+  else if(!_priv::add_listener(*cb, l))
+    l->expired();
+
+  return f;
+}
+
+#if OWNED_POINTER_HAS_COROUTINES
+
+namespace _priv
+{
+
+// Listener is shared by block and awaiter, whichever releases it second frees it.
+// Coroutine destroyed while suspended releases it first, so it is not resumed.
+class resume_listener final : public expiry_listener
+{
+public:
+  explicit resume_listener(const std::coroutine_handle<> h) noexcept : handle{h} {}
+
+  void expired() noexcept override
+  {
+    const auto h = handle;
+    if(!release()) h.resume();
+  }
+
+  void dropped() noexcept override { release(); }
+
+  auto release() noexcept -> bool
+  {
+    if(!released.exchange(true, std::memory_order_acq_rel))
+      return false;
+
+    return delete this, true;
+  }
+
+private:
+  const std::coroutine_handle<> handle;
+  std::atomic<bool> released{false};
+};
+
+} // namespace _priv
+
+// Awaiter keeps owned_pointer, so coroutine is resumed only by deletion of object.
+// Null pointer is never deleted and doesn't suspend.
+template<typename T, typename D>
+class expiry_awaiter
+{
+  static_assert(_priv::is_expired_enabled<T>::value, "Deletion of this type is never reported");
+
+public:
+  explicit expiry_awaiter(owned_pointer<T, D> p) noexcept : pointer{std::move(p)} {}
+
+  expiry_awaiter(expiry_awaiter&&) = delete;
+  expiry_awaiter& operator=(expiry_awaiter&&) = delete;
+
+  ~expiry_awaiter()
+  {
+    if(listener) listener->release();
+  }
+
+  auto await_ready() const noexcept -> bool { return !_priv::owned_access::block(pointer) || pointer.expired(); }
+
+  auto await_suspend(const std::coroutine_handle<> h) -> bool
+  {
+    listener = new _priv::resume_listener{h};
+    if(_priv::add_listener(*_priv::owned_access::block(pointer), listener))
+      return true;
+
+    delete listener;
+    return listener = nullptr, false;
+  }
+
+  void await_resume() noexcept
+  {
+    if(listener) listener->release();
+    listener = nullptr;
+  }
+
+private:
+  owned_pointer<T, D> pointer;
+  _priv::resume_listener* listener{nullptr};
+};
+
+template<typename T, typename D>
+inline auto until_expired(owned_pointer<T, D> p) noexcept -> expiry_awaiter<T, D>
+{
+  return expiry_awaiter<T, D>{std::move(p)};
+}
+
+#endif
+
+} // namespace csp
@@ -0,0 +1,63 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <memory>
+
+// Declarations only, for headers which hold owned_pointer members or take them as
+// parameters. Full definitions are in owned_pointer.hpp and basic_owned_pointer.hpp.
+
+namespace csp
+{
+
+namespace _priv
+{
+struct single_thread_count;
+struct atomic_count;
+}
+
+template<typename Tp, typename Deleter = std::default_delete<Tp>>
+class owned_pointer;
+
+template<typename T>
+class borrowed_ptr;
+
+template<typename Tp, typename Count>
+class basic_owned_pointer;
+
+template<typename T>
+using owned_pointer_st = basic_owned_pointer<T, _priv::single_thread_count>;
+
+template<typename T>
+using compact_owned_pointer = basic_owned_pointer<T, _priv::atomic_count>;
+
+template<typename T>
+class owned_pointer_set;
+
+template<typename T>
+class owned_scope_allocator;
+
+class owned_scope;
+
+} // namespace csp
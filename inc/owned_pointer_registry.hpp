@@ -0,0 +1,194 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "owned_pointer_stats.hpp"
+
+namespace csp
+{
+
+namespace _priv
+{
+
+/*****************************************************************************************
+ *
+ * Registry of live entries, split in per thread shards of fixed size slot chunks.
+ * Insert claims free slot in shard of calling thread with compare-and-swap, remove
+ * clears slot from any thread. Chunks are never freed, so slot pointers stay valid.
+ * Iteration must not race with destruction of registered entries.
+ *
+ *****************************************************************************************/
+
+template<typename T>
+class sharded_registry
+{
+public:
+  using slot_type = std::atomic<T*>;
+
+  // nullptr when chunk could not be allocated, entry is just not registered then
+  auto insert(T *const p) noexcept -> slot_type*
+  {
+    auto& s = shards[shard_index()];
+    const auto start = s.cursor.load(std::memory_order_acquire);
+
+    for(auto c = start; c; c = c->next)
+      if(const auto slot = c->claim(p)) return s.cursor.store(c, std::memory_order_release), slot;
+
+    for(auto c = s.head.load(std::memory_order_acquire); c != start; c = c->next)
+      if(const auto slot = c->claim(p)) return s.cursor.store(c, std::memory_order_release), slot;
+
+    const auto c = new(std::nothrow) chunk;
+    if(!c) return nullptr;
+
+    const auto slot = c->claim(p);
+
+    c->next = s.head.load(std::memory_order_relaxed);
+    while(!s.head.compare_exchange_weak(c->next, c, std::memory_order_release, std::memory_order_relaxed))
+    {}
+
+    return s.cursor.store(c, std::memory_order_release), slot;
+  }
+
+  static void remove(slot_type *const slot) noexcept
+  {
+    slot->store(nullptr, std::memory_order_release);
+  }
+
+  template<typename F>
+  void for_each(F f) const
+  {
+    for(const auto& s : shards)
+      for(auto c = s.head.load(std::memory_order_acquire); c; c = c->next)
+        for(const auto& slot : c->slots)
+          if(const auto p = slot.load(std::memory_order_acquire)) f(*p);
+  }
+
+private:
+  static constexpr std::size_t chunk_slots = 256;
+
+  struct chunk
+  {
+    chunk() noexcept
+    {
+      for(auto& slot : slots) slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    auto claim(T *const p) noexcept -> slot_type*
+    {
+      for(std::size_t i = 0; i < chunk_slots; i++)
+      {
+        const auto start = hint.load(std::memory_order_relaxed);
+        auto& slot = slots[(start + i) % chunk_slots];
+        T* expected{nullptr};
+
+        if(slot.load(std::memory_order_relaxed) == nullptr &&
+           slot.compare_exchange_strong(expected, p, std::memory_order_release, std::memory_order_relaxed))
+          return hint.store((start + i + 1) % chunk_slots, std::memory_order_relaxed), &slot;
+      }
+      return nullptr;
+    }
+
+    slot_type slots[chunk_slots];
+    chunk* next{nullptr};
+
+    // only a hint, concurrent updates just start next search elsewhere
+    std::atomic<std::size_t> hint{0};
+  };
+
+  struct alignas(64) shard
+  {
+    std::atomic<chunk*> head{nullptr};
+    std::atomic<chunk*> cursor{nullptr};
+  };
+
+  shard shards[stats_shards];
+};
+
+inline auto registry_serial() noexcept -> std::atomic<std::uint64_t>&
+{
+  static std::atomic<std::uint64_t> serial{0};
+  return serial;
+}
+
+inline auto current_site() noexcept -> const char*&
+{
+  static thread_local const char* site{"unknown"};
+  return site;
+}
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * Labels control blocks created by current thread in its scope, with define
+ * OWNED_POINTER_REGISTRY. Label is not copied, it has to outlive registered objects.
+ *
+ *****************************************************************************************/
+
+class registry_site
+{
+public:
+  explicit registry_site(const char *const site) noexcept : previous{_priv::current_site()}
+  {
+    _priv::current_site() = site;
+  }
+
+  registry_site(const registry_site&) = delete;
+  registry_site& operator=(const registry_site&) = delete;
+
+  ~registry_site() { _priv::current_site() = previous; }
+
+private:
+  const char* const previous;
+};
+
+#define OWNED_POINTER_STRINGIFY_(x) #x
+#define OWNED_POINTER_STRINGIFY(x) OWNED_POINTER_STRINGIFY_(x)
+#define OWNED_POINTER_SITE_NAME_(line) owned_pointer_site_ ## line
+#define OWNED_POINTER_SITE_NAME(line) OWNED_POINTER_SITE_NAME_(line)
+
+// Labels objects created in enclosing scope with file and line
+#define OWNED_POINTER_SITE() \
+  const ::csp::registry_site OWNED_POINTER_SITE_NAME(__LINE__){__FILE__ ":" OWNED_POINTER_STRINGIFY(__LINE__)}
+
+struct live_object
+{
+  const void* address;
+  const char* type_name;
+  const char* site;
+  bool acquired;
+  bool deleted;
+};
+
+// Objects registered after mark was taken have serial not less than it
+inline auto registry_mark() noexcept -> std::uint64_t
+{
+  return _priv::registry_serial().load(std::memory_order_acquire);
+}
+
+} // namespace csp
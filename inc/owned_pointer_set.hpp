@@ -0,0 +1,269 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <deque>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "owned_pointer.hpp"
+
+namespace csp
+{
+
+namespace _priv
+{
+
+inline auto lowest_bit(const std::uint64_t w) noexcept -> std::size_t
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<std::size_t>(__builtin_ctzll(w));
+#else
+  std::size_t i{0};
+  while(!(w & (std::uint64_t{1} << i))) ++i;
+  return i;
+#endif
+}
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * owned_pointer_set keeps acquired and deleted state of its elements in dense bitmaps,
+ * which are updated by control blocks. Every deletion bumps epoch, so checking if
+ * anything died is O(1) and sweep() visits only bitmap words and expired elements.
+ * Slots are stable, removed ones are reused by insert(). Set must be modified from one
+ * thread, objects can be deleted from any (with OWNED_POINTER_THREAD_SAFE). Removing an
+ * element waits until notifications of its block, which are in progress, are done.
+ *
+ *****************************************************************************************/
+
+template<typename T>
+class owned_pointer_set : _priv::state_observer
+{
+public:
+  using value_type = owned_pointer<T>;
+  using size_type = std::size_t;
+
+  owned_pointer_set() = default;
+
+  owned_pointer_set(const owned_pointer_set&) = delete;
+  owned_pointer_set& operator=(const owned_pointer_set&) = delete;
+
+  ~owned_pointer_set() { clear(); }
+
+  auto insert(value_type p) -> size_type;
+  void erase(const size_type slot);
+  void clear() noexcept;
+
+  auto sweep() -> size_type;
+
+  template<typename F>
+  auto sweep(F on_expired) -> size_type;
+
+  template<typename F>
+  void for_each(F f) const;
+
+  auto operator[](const size_type slot) const noexcept -> const value_type& { return items[slot]; }
+
+  auto size() const noexcept -> size_type { return live_count; }
+  auto empty() const noexcept -> bool { return live_count == 0; }
+
+  auto contains(const size_type slot) const noexcept -> bool { return test(live, slot); }
+  auto expired(const size_type slot) const noexcept -> bool { return test(deleted_bits, slot); }
+  auto acquired(const size_type slot) const noexcept -> bool { return test(acquired_bits, slot); }
+
+  auto epoch() const noexcept -> std::uint64_t { return expirations.load(std::memory_order_acquire); }
+  auto expired_since(const std::uint64_t e) const noexcept -> bool { return epoch() != e; }
+
+private:
+  using word_type = std::uint64_t;
+  static constexpr size_type word_bits = 64;
+
+  static auto word(const size_type slot) noexcept -> size_type { return slot / word_bits; }
+  static auto bit(const size_type slot) noexcept -> word_type { return word_type{1} << (slot % word_bits); }
+
+  template<typename Words>
+  static auto test(const Words& w, const size_type slot) noexcept -> bool
+  {
+    return word(slot) < w.size() && (static_cast<word_type>(w[word(slot)]) & bit(slot));
+  }
+
+  void deleted(const size_type slot) noexcept override
+  {
+    deleted_bits[word(slot)].fetch_or(bit(slot), std::memory_order_release);
+    expirations.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  void acquired(const size_type slot, const bool value) noexcept override
+  {
+    if(value)
+      acquired_bits[word(slot)].fetch_or(bit(slot), std::memory_order_release);
+    else
+      acquired_bits[word(slot)].fetch_and(~bit(slot), std::memory_order_release);
+  }
+
+  auto allocate_slot() -> size_type;
+  void release_slot(const size_type slot) noexcept;
+
+  // deques keep addresses of words stable, when set grows
+  std::deque<value_type> items;
+  std::deque<word_type> live;
+  std::deque<std::atomic<word_type>> deleted_bits;
+  std::deque<std::atomic<word_type>> acquired_bits;
+  std::vector<size_type> free_slots;
+  size_type live_count{0};
+  std::atomic<std::uint64_t> expirations{0};
+};
+
+/*****************************************************************************************
+ *
+ * Public member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T>
+auto owned_pointer_set<T>::insert(value_type p) -> size_type
+{
+  const auto cb = _priv::owned_access::block(p);
+
+  const auto e = cb ? _priv::install_extras(*cb) : nullptr;
+
+  if(e && e->observer.load(std::memory_order_acquire))
+    throw ptr_is_already_observed();
+
+  const auto slot = allocate_slot();
+
+  if(p.acquired()) acquired_bits[word(slot)].fetch_or(bit(slot), std::memory_order_relaxed);
+  if(p.expired()) deleted_bits[word(slot)].fetch_or(bit(slot), std::memory_order_relaxed);
+
+  if(e)
+    _priv::attach_observer(*e, this, slot);
+
+  items[slot] = std::move(p);
+  return slot;
+}
+
+template<typename T>
+void owned_pointer_set<T>::erase(const size_type slot)
+{
+  if(contains(slot))
+    release_slot(slot);
+}
+
+template<typename T>
+void owned_pointer_set<T>::clear() noexcept
+{
+  for(size_type w = 0; w < live.size(); w++)
+    for(auto bits = live[w]; bits; bits &= bits - 1)
+      release_slot(w * word_bits + _priv::lowest_bit(bits));
+}
+
+template<typename T>
+auto owned_pointer_set<T>::sweep() -> size_type
+{
+  return sweep([](const value_type&){});
+}
+
+template<typename T> template<typename F>
+auto owned_pointer_set<T>::sweep(F on_expired) -> size_type
+{
+  size_type removed{0};
+
+  for(size_type w = 0; w < deleted_bits.size(); w++)
+  {
+    for(auto bits = deleted_bits[w].load(std::memory_order_acquire) & live[w]; bits; bits &= bits - 1)
+    {
+      const auto slot = w * word_bits + _priv::lowest_bit(bits);
+
+      on_expired(items[slot]);
+      release_slot(slot);
+      ++removed;
+    }
+  }
+
+  return removed;
+}
+
+template<typename T> template<typename F>
+void owned_pointer_set<T>::for_each(F f) const
+{
+  for(size_type w = 0; w < live.size(); w++)
+    for(auto bits = live[w]; bits; bits &= bits - 1)
+      f(items[w * word_bits + _priv::lowest_bit(bits)]);
+}
+
+/*****************************************************************************************
+ *
+ * Private member class functions
+ *
+ *****************************************************************************************/
+
+template<typename T>
+auto owned_pointer_set<T>::allocate_slot() -> size_type
+{
+  size_type slot;
+
+  if(!free_slots.empty())
+  {
+    slot = free_slots.back();
+    free_slots.pop_back();
+  }
+  else
+  {
+    slot = items.size();
+    items.emplace_back();
+    free_slots.reserve(items.size());
+
+    if(word(slot) == live.size())
+    {
+      live.emplace_back(0);
+      deleted_bits.emplace_back(0);
+      acquired_bits.emplace_back(0);
+    }
+  }
+
+  live[word(slot)] |= bit(slot);
+  ++live_count;
+
+  return slot;
+}
+
+template<typename T>
+void owned_pointer_set<T>::release_slot(const size_type slot) noexcept
+{
+  if(const auto cb = _priv::owned_access::block(items[slot]))
+    _priv::detach_observer(*cb);
+
+  items[slot] = nullptr;
+  live[word(slot)] &= ~bit(slot);
+  deleted_bits[word(slot)].fetch_and(~bit(slot), std::memory_order_relaxed);
+  acquired_bits[word(slot)].fetch_and(~bit(slot), std::memory_order_relaxed);
+  --live_count;
+
+  free_slots.push_back(slot);
+}
+
+} //namespace csp
@@ -0,0 +1,171 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <typeinfo>
+
+namespace csp
+{
+
+struct lifecycle_counters
+{
+  const char* type_name;
+  long created;
+  long acquired;
+  long expired;
+  long deleted_not_acquired;
+  long live;
+  long live_high_water;
+};
+
+namespace _priv
+{
+
+enum lifecycle_event : std::size_t { created_event, acquired_event, expired_event, not_acquired_event, events };
+
+constexpr std::size_t stats_shards = 16;
+
+inline auto shard_index() noexcept -> std::size_t
+{
+  static std::atomic<std::size_t> threads{0};
+  static thread_local const std::size_t index{threads.fetch_add(1, std::memory_order_relaxed) % stats_shards};
+  return index;
+}
+
+// Each thread increments its own shard with relaxed atomics. Only live count is shared,
+// because its high water mark has to be seen by all threads.
+struct alignas(64) lifecycle_shard
+{
+  std::atomic<long> counters[events];
+};
+
+struct lifecycle_record
+{
+  explicit lifecycle_record(const char *const name) noexcept;
+
+  void count(const lifecycle_event e) noexcept
+  {
+    shards[shard_index()].counters[e].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void created() noexcept
+  {
+    count(created_event);
+    const auto now = live.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto peak = live_high_water.load(std::memory_order_relaxed);
+
+    while(now > peak && !live_high_water.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+    {}
+  }
+
+  void destroyed() noexcept { live.fetch_sub(1, std::memory_order_relaxed); }
+
+  auto sum(const lifecycle_event e) const noexcept -> long
+  {
+    long s{0};
+    for(const auto& shard : shards) s += shard.counters[e].load(std::memory_order_relaxed);
+    return s;
+  }
+
+  const char* const type_name;
+  lifecycle_shard shards[stats_shards];
+  std::atomic<long> live{0};
+  std::atomic<long> live_high_water{0};
+  lifecycle_record* next{nullptr};
+};
+
+inline auto lifecycle_records() noexcept -> std::atomic<lifecycle_record*>&
+{
+  static std::atomic<lifecycle_record*> head{nullptr};
+  return head;
+}
+
+inline lifecycle_record::lifecycle_record(const char *const name) noexcept : type_name{name}
+{
+  for(auto& shard : shards)
+    for(auto& c : shard.counters) c.store(0, std::memory_order_relaxed);
+
+  auto& head = lifecycle_records();
+  next = head.load(std::memory_order_relaxed);
+  while(!head.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed))
+  {}
+}
+
+// Record is trivially destructible, so objects still alive during static destruction can count.
+template<typename T>
+inline auto lifecycle_record_of() noexcept -> lifecycle_record&
+{
+  static lifecycle_record record{typeid(T).name()};
+  return record;
+}
+
+inline auto counters_of(const lifecycle_record& r) noexcept -> lifecycle_counters
+{
+  return { r.type_name, r.sum(created_event), r.sum(acquired_event), r.sum(expired_event),
+           r.sum(not_acquired_event), r.live.load(std::memory_order_relaxed),
+           r.live_high_water.load(std::memory_order_relaxed) };
+}
+
+} // namespace _priv
+
+/*****************************************************************************************
+ *
+ * Lifecycle counters are collected only with define OWNED_POINTER_STATS, otherwise
+ * queries return zeros. Counters are kept per type of object owned by control block.
+ *
+ *****************************************************************************************/
+
+inline auto lifecycle_stats() -> std::vector<lifecycle_counters>
+{
+  std::vector<lifecycle_counters> stats;
+
+  for(auto r = _priv::lifecycle_records().load(std::memory_order_acquire); r; r = r->next)
+    stats.push_back(_priv::counters_of(*r));
+
+  return stats;
+}
+
+template<typename T>
+inline auto lifecycle_stats_of() noexcept -> lifecycle_counters
+{
+  return _priv::counters_of(_priv::lifecycle_record_of<T>());
+}
+
+// Not atomic as a whole, meant to be called between tests. High water mark starts
+// from current number of live blocks.
+inline void reset_lifecycle_stats() noexcept
+{
+  for(auto r = _priv::lifecycle_records().load(std::memory_order_acquire); r; r = r->next)
+  {
+    for(auto& shard : r->shards)
+      for(auto& c : shard.counters) c.store(0, std::memory_order_relaxed);
+
+    r->live_high_water.store(r->live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+}
+
+} // namespace csp
@@ -0,0 +1,63 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+module;
+
+// Standard headers go to global module fragment, so that headers below only
+// contribute owned_pointer declarations to exported block.
+#include <new>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <typeinfo>
+#include <stdexcept>
+#include <exception>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <memory_resource>
+#if __has_include(<coroutine>)
+#include <coroutine>
+#endif
+
+export module csp.owned_pointer;
+
+// Macros (OWNED_POINTER_SITE) don't cross module boundary and configuration defines
+// (OWNED_POINTER_THREAD_SAFE, ...) have to be given when this module is built.
+export extern "C++"
+{
+#include "owned_pointer.hpp"
+#include "basic_owned_pointer.hpp"
+#include "owned_pointer_set.hpp"
+#include "owned_map.hpp"
+#include "owned_pointer_expiry.hpp"
+}
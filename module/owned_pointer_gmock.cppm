@@ -0,0 +1,53 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+module;
+
+#include <mutex>
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <gmock/gmock.h>
+
+#define OWNED_POINTER_IMPORTED
+
+export module csp.owned_pointer.gmock;
+
+export import csp.owned_pointer;
+
+// MOCK_UNIQUE_* are macros, they still come from header, which then skips
+// declarations exported here:
+//
+//   import csp.owned_pointer.gmock;
+//   #define OWNED_POINTER_IMPORTED
+//   #include "gmock_macros_for_unique_ptr.hpp"
+export extern "C++"
+{
+#include "gmock_unique_ptr_support.hpp"
+#include "gmock_owned_actions.hpp"
+#include "gmock_owned_matchers.hpp"
+}
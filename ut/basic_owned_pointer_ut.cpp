@@ -0,0 +1,274 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "basic_owned_pointer.hpp"
+
+using namespace ::testing;
+
+class basic_owned_pointer_ut : public ::testing::Test
+{
+protected:
+  struct simple_base_class
+  {
+    virtual ~simple_base_class() = default;
+  };
+
+  struct destruction_test_mock : public simple_base_class
+  {
+    int x;
+    destruction_test_mock(int y = 1) : x(y) {}
+
+    MOCK_METHOD0(die, void());
+    virtual ~destruction_test_mock(){ x = 0; die(); }
+  };
+
+  typedef StrictMock<destruction_test_mock> test_mock;
+
+  template<typename T> void assert_that_operators_throw(csp::owned_pointer_st<T> &p)
+  {
+    ASSERT_TRUE(p.expired());
+    ASSERT_TRUE(p.get(std::nothrow) == nullptr);
+
+    ASSERT_THROW(*p, csp::ptr_is_already_deleted);
+    ASSERT_THROW(p.get(), csp::ptr_is_already_deleted);
+    ASSERT_THROW(p.operator->(), csp::ptr_is_already_deleted);
+  }
+
+  void expect_object_will_be_deleted(csp::owned_pointer_st<destruction_test_mock> p)
+  {
+    EXPECT_CALL(*p, die()).Times(1);
+  }
+};
+
+TEST_F(basic_owned_pointer_ut, handleIsSinglePointer)
+{
+  ASSERT_EQ(sizeof(csp::owned_pointer_st<test_mock>), sizeof(void*));
+}
+
+TEST_F(basic_owned_pointer_ut, objectWillBeDeletedWhenNotAcquired)
+{
+  auto p = csp::make_owned_st<test_mock>(199);
+  auto r = p;
+
+  ASSERT_EQ(p.use_count(), 2);
+  ASSERT_FALSE(p.acquired());
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(basic_owned_pointer_ut, expiredWhenUniquePtrDeletesObject)
+{
+  auto p = csp::make_owned_st<test_mock>();
+  expect_object_will_be_deleted(p);
+  {
+    auto u = p.unique_ptr();
+    ASSERT_TRUE(p.acquired());
+    ASSERT_THROW(p.unique_ptr(), csp::unique_ptr_already_acquired);
+  }
+
+  assert_that_operators_throw(p);
+  ASSERT_THROW(p.unique_ptr(), csp::ptr_is_already_deleted);
+}
+
+TEST_F(basic_owned_pointer_ut, acquiredObjectOutlivesAllHandles)
+{
+  std::unique_ptr<test_mock> u;
+  {
+    auto p = csp::make_owned_st<test_mock>(0x123);
+    u = p.unique_ptr();
+  }
+
+  Mock::VerifyAndClearExpectations(u.get());
+
+  EXPECT_CALL(*u, die()).Times(1);
+  ASSERT_EQ(u->x, 0x123);
+}
+
+TEST_F(basic_owned_pointer_ut, sharedStateIsFoundAgainFromUniquePtr)
+{
+  auto p = csp::make_owned_st<test_mock>();
+  auto u = p.unique_ptr();
+
+  csp::owned_pointer_st<test_mock> l = csp::link(u);
+  ASSERT_TRUE(l.acquired());
+  ASSERT_EQ(p.use_count(), 2);
+
+  csp::owned_pointer_st<test_mock> r{std::move(u)};
+  ASSERT_FALSE(p.acquired());
+  ASSERT_EQ(p, r);
+  expect_object_will_be_deleted(r);
+}
+
+TEST_F(basic_owned_pointer_ut, conversionAndCompare)
+{
+  auto p = csp::make_owned_st<test_mock>();
+  csp::owned_pointer_st<simple_base_class> b = p;
+  csp::owned_pointer_st<int> n;
+
+  ASSERT_EQ(b, p);
+  ASSERT_TRUE(n == nullptr);
+  ASSERT_TRUE(p != nullptr);
+  ASSERT_TRUE(p == p.get());
+  ASSERT_EQ(p.use_count(), 2);
+
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(basic_owned_pointer_ut, nonPolymorphicTypes)
+{
+  auto p = csp::make_owned_st<std::vector<int>>(3, 7);
+  ASSERT_THAT(*p, ElementsAre(3, 7));
+
+  auto u = p.unique_ptr();
+  ASSERT_EQ(u.get(), p.get());
+
+  csp::owned_pointer_st<int> i{std::unique_ptr<int>{new int{5}}};
+  ASSERT_EQ(*i, 5);
+}
+
+TEST_F(basic_owned_pointer_ut, borrowChecksExpiryOnce)
+{
+  auto p = csp::make_owned_st<test_mock>(0x10);
+  auto u = p.unique_ptr();
+
+  ASSERT_EQ(p.borrow()->x, 0x10);
+
+  expect_object_will_be_deleted(p);
+  u.reset();
+
+  ASSERT_THROW(p.borrow(), csp::ptr_is_already_deleted);
+}
+
+TEST_F(basic_owned_pointer_ut, compactHandleIsSinglePointer)
+{
+  ASSERT_EQ(sizeof(csp::compact_owned_pointer<test_mock>), sizeof(void*));
+  ASSERT_TRUE(csp::is_expired_enabled<csp::compact_owned_pointer<test_mock>>::value);
+  ASSERT_FALSE(csp::is_expired_enabled<csp::compact_owned_pointer<int>>::value);
+}
+
+TEST_F(basic_owned_pointer_ut, compactHandleTracksExpiry)
+{
+  std::vector<csp::compact_owned_pointer<destruction_test_mock>> v(3, nullptr);
+  std::vector<std::unique_ptr<destruction_test_mock>> u;
+
+  for(auto& e : v)
+  {
+    e = csp::make_compact_owned<test_mock>();
+    EXPECT_CALL(*e, die());
+    u.push_back(e.unique_ptr());
+  }
+
+  u.erase(u.begin());
+
+  ASSERT_TRUE(v[0].expired());
+  ASSERT_FALSE(v[1].expired());
+  ASSERT_EQ(v[2].use_count(), 1);
+}
+
+TEST_F(basic_owned_pointer_ut, rvalueCastsStealBlock)
+{
+  auto p = csp::make_compact_owned<test_mock>();
+  auto q = p;
+
+  csp::compact_owned_pointer<simple_base_class> b = std::move(q);
+  ASSERT_FALSE(q);
+  ASSERT_EQ(p.use_count(), 2);
+
+  auto d = csp::static_pointer_cast<destruction_test_mock>(csp::compact_owned_pointer<destruction_test_mock>{p});
+  ASSERT_EQ(p.use_count(), 3);
+
+  EXPECT_CALL(*p, die());
+}
+
+TEST_F(basic_owned_pointer_ut, baseHandleFromDerivedUniquePtrFindsEmbeddedBlock)
+{
+  auto p = csp::make_owned_st<test_mock>();
+  std::unique_ptr<simple_base_class> u{p.unique_ptr()};
+
+  csp::owned_pointer_st<simple_base_class> l = csp::link(u);
+  ASSERT_EQ(p.use_count(), 2);
+
+  EXPECT_CALL(*p, die());
+  u.reset();
+
+  ASSERT_TRUE(l.expired());
+  assert_that_operators_throw(p);
+}
+
+namespace
+{
+struct final_class final
+{
+  virtual ~final_class() = default;
+  int x{7};
+};
+
+struct alignas(64) aligned_class
+{
+  virtual ~aligned_class() = default;
+  int x{8};
+};
+} // namespace
+
+#ifdef __cpp_aligned_new
+TEST_F(basic_owned_pointer_ut, overAlignedObjectIsEmbeddedAtItsAlignment)
+{
+  auto p = csp::make_compact_owned<aligned_class>();
+  auto s = csp::make_owned_st<aligned_class>();
+
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p.get()) % alignof(aligned_class), 0u);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(s.get()) % alignof(aligned_class), 0u);
+  ASSERT_EQ(p->x + s->x, 16);
+}
+#endif
+
+TEST_F(basic_owned_pointer_ut, finalPolymorphicTypeGetsSeparateBlock)
+{
+  auto p = csp::make_compact_owned<final_class>();
+  ASSERT_EQ(p->x, 7);
+  ASSERT_FALSE(csp::is_expired_enabled<csp::compact_owned_pointer<final_class>>::value);
+
+  csp::owned_pointer_st<final_class> s{std::unique_ptr<final_class>{new final_class}};
+  ASSERT_EQ(s.use_count(), 1);
+}
+
+TEST_F(basic_owned_pointer_ut, dynamicPointerCast)
+{
+  auto p = csp::make_owned_st<test_mock>();
+  csp::owned_pointer_st<simple_base_class> b = p;
+
+  auto d = csp::dynamic_pointer_cast<destruction_test_mock>(b);
+  ASSERT_EQ(d, p);
+  ASSERT_EQ(p.use_count(), 3);
+
+  auto m = csp::dynamic_pointer_cast<destruction_test_mock>(std::move(b));
+  ASSERT_FALSE(b);
+  ASSERT_EQ(p.use_count(), 3);
+
+  csp::owned_pointer_st<simple_base_class> o = csp::make_owned_st<simple_base_class>();
+  ASSERT_FALSE(csp::dynamic_pointer_cast<destruction_test_mock>(o));
+
+  EXPECT_CALL(*p, die());
+}
@@ -0,0 +1,139 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <unordered_set>
+#include "owned_map.hpp"
+
+using namespace ::testing;
+
+class owned_map_ut : public ::testing::Test
+{
+protected:
+  struct simple_base_class
+  {
+    int x = 0;
+    virtual ~simple_base_class() = default;
+  };
+
+  using map_type = csp::owned_map<simple_base_class, int>;
+
+  std::vector<csp::owned_pointer<simple_base_class>> fill(map_type& m, const int n)
+  {
+    std::vector<csp::owned_pointer<simple_base_class>> keys;
+
+    for(int i = 0; i < n; i++)
+    {
+      keys.push_back(csp::make_owned<simple_base_class>());
+      m.insert(keys.back(), i);
+    }
+
+    return keys;
+  }
+};
+
+TEST_F(owned_map_ut, findsKeysByHandleRawPointerAndUniquePtr)
+{
+  map_type m;
+  const auto keys = fill(m, 100);
+
+  ASSERT_EQ(m.size(), 100u);
+  ASSERT_EQ(m.at(keys[10]), 10);
+  ASSERT_EQ(m.find(keys[20].get())->second, 20);
+
+  auto u = keys[30].unique_ptr();
+  ASSERT_EQ(m.find(u)->second, 30);
+  ASSERT_TRUE(m.find(u)->first.acquired());
+
+  u.reset();
+  ASSERT_TRUE(m.contains(keys[30]));
+  ASSERT_EQ(m.at(keys[30]), 30);
+
+  const auto other = csp::make_owned<simple_base_class>();
+  ASSERT_FALSE(m.contains(other));
+  ASSERT_FALSE(m.contains(static_cast<simple_base_class*>(nullptr)));
+  ASSERT_THROW(m.at(other), std::out_of_range);
+}
+
+TEST_F(owned_map_ut, insertKeepsFirstValueAndRejectsNull)
+{
+  map_type m;
+  const auto p = csp::make_owned<simple_base_class>();
+
+  ASSERT_TRUE(m.insert(p, 1).second);
+  ASSERT_FALSE(m.insert(p, 2).second);
+  ASSERT_EQ(m.at(p), 1);
+
+  ASSERT_FALSE(m.insert(nullptr, 3).second);
+  ASSERT_EQ(m.size(), 1u);
+}
+
+TEST_F(owned_map_ut, eraseKeepsOtherKeysReachable)
+{
+  map_type m;
+  m.reserve(20);
+  const auto keys = fill(m, 500);
+
+  for(int i = 0; i < 500; i += 3)
+    ASSERT_EQ(m.erase(keys[i]), 1u);
+
+  ASSERT_EQ(m.erase(keys[0]), 0u);
+  ASSERT_EQ(m.size(), 333u);
+
+  for(int i = 0; i < 500; i++)
+  {
+    ASSERT_EQ(m.contains(keys[i].get()), i % 3 != 0);
+    if(i % 3)
+    {
+      ASSERT_EQ(m.at(keys[i]), i);
+    }
+  }
+
+  int sum = 0;
+  for(const auto& e : m)
+    sum += e.second;
+  ASSERT_EQ(sum, 500 * 499 / 2 - 3 * (166 * 167 / 2));
+
+  m.clear();
+  ASSERT_TRUE(m.empty());
+  ASSERT_FALSE(m.contains(keys[1]));
+}
+
+TEST_F(owned_map_ut, stdHashAndTransparentFunctorsUseStoredAddress)
+{
+  auto p = csp::make_owned<simple_base_class>();
+  auto u = p.unique_ptr();
+
+  ASSERT_EQ(std::hash<csp::owned_pointer<simple_base_class>>()(p), csp::owned_hash()(u.get()));
+  ASSERT_EQ(csp::owned_hash()(p), csp::owned_hash()(u));
+  ASSERT_TRUE(csp::owned_equal()(p, u));
+  ASSERT_TRUE(csp::owned_equal()(u.get(), p));
+
+  u.reset();
+  ASSERT_NO_THROW(std::hash<csp::owned_pointer<simple_base_class>>()(p));
+
+  std::unordered_set<csp::owned_pointer<simple_base_class>> s{p};
+  ASSERT_EQ(s.count(p), 1u);
+}
@@ -0,0 +1,262 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifndef OWNED_POINTER_THREAD_SAFE
+#error "owned_pointer_mt_ut has to be compiled with OWNED_POINTER_THREAD_SAFE"
+#endif
+
+#include "owned_pointer.hpp"
+#include "basic_owned_pointer.hpp"
+#include "owned_pointer_set.hpp"
+#include "owned_pointer_expiry.hpp"
+
+using namespace ::testing;
+
+class owned_pointer_mt_ut : public ::testing::Test
+{
+protected:
+  struct simple_base_class
+  {
+    int x = 0;
+    virtual ~simple_base_class() = default;
+  };
+
+  struct tracked_value final
+  {
+    OWNED_POINTER_TRACK_DELETE()
+    int x = 0;
+  };
+
+  static constexpr int number_of_threads = 8;
+
+  template<typename F>
+  void run_in_parallel(F f)
+  {
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+
+    for(int i = 0; i < number_of_threads; i++)
+      threads.emplace_back([&, i]{ while(!start.load()) std::this_thread::yield(); f(i); });
+
+    start = true;
+    for(auto& t : threads) t.join();
+  }
+};
+
+TEST_F(owned_pointer_mt_ut, onlyOneThreadAcquiresUniquePtr)
+{
+  for(int round = 0; round < 100; round++)
+  {
+    auto p = csp::make_owned<simple_base_class>();
+    std::atomic<int> acquired{0}, rejected{0};
+    std::vector<std::unique_ptr<simple_base_class>> owners(number_of_threads);
+
+    run_in_parallel([&](int i)
+    {
+      try
+      {
+        owners[i] = p.unique_ptr();
+        ++acquired;
+      }
+      catch(const csp::unique_ptr_already_acquired&)
+      {
+        ++rejected;
+      }
+    });
+
+    ASSERT_EQ(acquired.load(), 1);
+    ASSERT_EQ(rejected.load(), number_of_threads - 1);
+    ASSERT_TRUE(p.acquired());
+  }
+}
+
+TEST_F(owned_pointer_mt_ut, racingFirstSharesAllSucceed)
+{
+  for(int round = 0; round < 100; round++)
+  {
+    auto p = csp::make_owned<simple_base_class>();
+    std::vector<std::shared_ptr<simple_base_class>> sharers(number_of_threads);
+
+    run_in_parallel([&](int i){ sharers[i] = p.shared_ptr(); });
+
+    for(const auto& s : sharers)
+      ASSERT_EQ(s.get(), p.get());
+    ASSERT_THROW(p.unique_ptr(), csp::unique_ptr_already_acquired);
+  }
+}
+
+TEST_F(owned_pointer_mt_ut, expiredIsVisibleInOtherThread)
+{
+  auto p = csp::make_owned<simple_base_class>();
+  auto u = p.unique_ptr();
+
+  std::thread cut{[&u]{ u->x = 10; u.reset(); }};
+  while(!p.expired()) std::this_thread::yield();
+  cut.join();
+
+  ASSERT_EQ(p.get(std::nothrow), nullptr);
+}
+
+TEST_F(owned_pointer_mt_ut, scopeKeepsControlBlocksInSeparateCacheLines)
+{
+  csp::owned_scope scope;
+
+  auto p = csp::make_owned<simple_base_class>();
+  auto r = csp::make_owned<simple_base_class>();
+
+  const auto distance = reinterpret_cast<std::uintptr_t>(r.get()) - reinterpret_cast<std::uintptr_t>(p.get());
+
+  ASSERT_GE(distance, csp::_priv::cache_line_size);
+  ASSERT_EQ(distance % csp::_priv::cache_line_size, 0u);
+}
+
+TEST_F(owned_pointer_mt_ut, compactHandlesAreCopiedInParallel)
+{
+  auto p = csp::make_compact_owned<simple_base_class>();
+  std::atomic<int> acquired{0};
+  std::vector<std::unique_ptr<simple_base_class>> owners(number_of_threads);
+
+  run_in_parallel([&](int i)
+  {
+    for(int n = 0; n < 1000; n++)
+    {
+      auto copy = p;
+      csp::compact_owned_pointer<simple_base_class> moved{std::move(copy)};
+    }
+
+    try
+    {
+      owners[i] = p.unique_ptr();
+      ++acquired;
+    }
+    catch(const csp::unique_ptr_already_acquired&) {}
+  });
+
+  ASSERT_EQ(acquired.load(), 1);
+  ASSERT_EQ(p.use_count(), 1);
+}
+
+TEST_F(owned_pointer_mt_ut, setLearnsAboutDeletionsFromOtherThreads)
+{
+  csp::owned_pointer_set<simple_base_class> s;
+  std::vector<std::unique_ptr<simple_base_class>> owners;
+
+  for(int i = 0; i < number_of_threads; i++)
+    owners.push_back(s[s.insert(csp::make_owned<simple_base_class>())].unique_ptr());
+
+  const auto e = s.epoch();
+  run_in_parallel([&](int i){ owners[i].reset(); });
+
+  while(s.epoch() - e != number_of_threads) std::this_thread::yield();
+  ASSERT_EQ(s.sweep(), static_cast<std::size_t>(number_of_threads));
+}
+
+TEST_F(owned_pointer_mt_ut, setEraseRacesWithDeletions)
+{
+  std::vector<std::unique_ptr<simple_base_class>> owners;
+  {
+    csp::owned_pointer_set<simple_base_class> s;
+    std::vector<std::size_t> slots;
+
+    for(int i = 0; i < number_of_threads * 100; i++)
+    {
+      slots.push_back(s.insert(csp::make_owned<simple_base_class>()));
+      owners.push_back(s[slots.back()].unique_ptr());
+    }
+
+    // thread 0 modifies set, others delete its objects at the same time
+    run_in_parallel([&](int i)
+    {
+      if(!i)
+        for(const auto slot : slots) s.erase(slot);
+      else
+        for(auto n = static_cast<std::size_t>(i - 1); n < owners.size(); n += number_of_threads - 1)
+          owners[n].reset();
+    });
+
+    ASSERT_TRUE(s.empty());
+  }
+
+  for(const auto& o : owners)
+    ASSERT_FALSE(o);
+}
+
+TEST_F(owned_pointer_mt_ut, trackedDeletionsRaceWithLastHandles)
+{
+  std::vector<csp::owned_pointer<tracked_value>> handles;
+  std::vector<std::unique_ptr<tracked_value>> owners;
+
+  for(int i = 0; i < number_of_threads * 100; i++)
+  {
+    handles.push_back(csp::make_owned<tracked_value>());
+    owners.push_back(handles.back().unique_ptr());
+  }
+
+  // even thread deletes objects, odd one drops last owned_pointers of the same objects,
+  // so deletion may report to control block being destroyed
+  run_in_parallel([&](int i)
+  {
+    for(auto n = static_cast<std::size_t>(i / 2); n < owners.size(); n += number_of_threads / 2)
+      i % 2 ? (void)(handles[n] = nullptr) : owners[n].reset();
+  });
+
+  for(std::size_t n = 0; n < owners.size(); n++)
+    ASSERT_TRUE(!owners[n] && !handles[n]);
+}
+
+TEST_F(owned_pointer_mt_ut, expiryFutureWaitsForOtherThread)
+{
+  auto p = csp::make_owned<simple_base_class>();
+  auto expired = csp::expiry_future(p);
+  auto u = p.unique_ptr();
+
+  std::thread cut{[&u]{ u->x = 10; u.reset(); }};
+  expired.wait();
+  cut.join();
+
+  ASSERT_TRUE(p.expired());
+}
+
+TEST_F(owned_pointer_mt_ut, lazyObjectIsConstructedOnceByRacingThreads)
+{
+  auto p = csp::make_owned_lazy<simple_base_class>();
+  std::atomic<int> ready{0};
+  simple_base_class* seen[4];
+  std::vector<std::thread> threads;
+
+  for(int i = 0; i < 4; i++)
+    threads.emplace_back([&, i]{ ready++; while(ready < 4); seen[i] = p.get(); });
+
+  for(auto& t : threads)
+    t.join();
+
+  for(const auto s : seen)
+    ASSERT_EQ(s, p.get());
+}
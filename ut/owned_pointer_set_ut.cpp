@@ -0,0 +1,118 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "owned_pointer_set.hpp"
+
+using namespace ::testing;
+
+class owned_pointer_set_ut : public ::testing::Test
+{
+protected:
+  struct simple_base_class
+  {
+    int x = 0;
+    virtual ~simple_base_class() = default;
+  };
+
+  using set_type = csp::owned_pointer_set<simple_base_class>;
+
+  std::vector<std::size_t> fill(set_type& s, const std::size_t n)
+  {
+    std::vector<std::size_t> slots;
+
+    for(std::size_t i = 0; i < n; i++)
+      slots.push_back(s.insert(csp::make_owned<simple_base_class>()));
+
+    return slots;
+  }
+};
+
+TEST_F(owned_pointer_set_ut, epochChangesOnlyWhenObjectDies)
+{
+  set_type s;
+  const auto slots = fill(s, 100);
+  const auto e = s.epoch();
+
+  auto u = s[slots[70]].unique_ptr();
+
+  ASSERT_FALSE(s.expired_since(e));
+  ASSERT_TRUE(s.acquired(slots[70]));
+  ASSERT_FALSE(s.acquired(slots[71]));
+
+  u.reset();
+
+  ASSERT_TRUE(s.expired_since(e));
+  ASSERT_TRUE(s.expired(slots[70]));
+  ASSERT_FALSE(s.expired(slots[69]));
+}
+
+TEST_F(owned_pointer_set_ut, sweepRemovesOnlyExpiredElements)
+{
+  set_type s;
+  const auto slots = fill(s, 130);
+  std::vector<std::unique_ptr<simple_base_class>> u;
+
+  for(auto i : {3u, 64u, 129u})
+    u.push_back(s[slots[i]].unique_ptr());
+
+  u.clear();
+
+  std::vector<std::size_t> visited;
+  ASSERT_EQ(s.sweep([&](const csp::owned_pointer<simple_base_class>& p){ visited.push_back(p.expired()); }), 3u);
+
+  ASSERT_THAT(visited, Each(Eq(1u)));
+  ASSERT_EQ(s.size(), 127u);
+  ASSERT_FALSE(s.contains(slots[64]));
+  ASSERT_TRUE(s.contains(slots[65]));
+  ASSERT_EQ(s.sweep(), 0u);
+}
+
+TEST_F(owned_pointer_set_ut, slotsAreReusedAndPointerCanMoveToOtherSet)
+{
+  set_type s, other;
+  auto p = csp::make_owned<simple_base_class>();
+  const auto slot = s.insert(p);
+
+  ASSERT_THROW(other.insert(p), csp::ptr_is_already_observed);
+
+  s.erase(slot);
+  ASSERT_TRUE(s.empty());
+  ASSERT_NO_THROW(other.insert(p));
+
+  ASSERT_EQ(s.insert(csp::make_owned<simple_base_class>()), slot);
+}
+
+TEST_F(owned_pointer_set_ut, forEachVisitsLiveElements)
+{
+  set_type s;
+  const auto slots = fill(s, 10);
+  s.erase(slots[4]);
+
+  int visited{0};
+  s.for_each([&](const csp::owned_pointer<simple_base_class>& p){ visited += p->x + 1; });
+
+  ASSERT_EQ(visited, 9);
+}
@@ -0,0 +1,218 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Przemyslaw Wos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+**/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+#include <sstream>
+
+#include <algorithm>
+#include <gtest/gtest-spi.h>
+
+#if !defined(OWNED_POINTER_STATS) || !defined(OWNED_POINTER_REGISTRY)
+#error "owned_pointer_stats_ut has to be compiled with OWNED_POINTER_STATS and OWNED_POINTER_REGISTRY"
+#endif
+
+#include "owned_pointer.hpp"
+#include "gtest_owned_leak_check.hpp"
+#include "gtest_lifecycle_stats_listener.hpp"
+
+using namespace ::testing;
+
+class owned_pointer_stats_ut : public ::testing::Test
+{
+protected:
+  struct simple_base_class
+  {
+    int x = 0;
+    virtual ~simple_base_class() = default;
+  };
+
+  struct other_class : simple_base_class {};
+
+  struct tracked_value final
+  {
+    OWNED_POINTER_TRACK_DELETE()
+    int x = 0;
+  };
+
+  void SetUp() override { csp::reset_lifecycle_stats(); }
+  void TearDown() override { leak_check.verify(); }
+
+  csp::owned_leak_check leak_check;
+  const std::uint64_t mark{csp::registry_mark()};
+};
+
+TEST_F(owned_pointer_stats_ut, countsLifecycleOfExpiredEnabledObjects)
+{
+  {
+    auto a = csp::make_owned<simple_base_class>();
+    auto b = csp::make_owned<simple_base_class>();
+    auto c = csp::make_owned<simple_base_class>();
+
+    a.unique_ptr().reset();
+    ASSERT_EQ(csp::lifecycle_stats_of<simple_base_class>().live, 3);
+  }
+
+  const auto s = csp::lifecycle_stats_of<simple_base_class>();
+
+  ASSERT_EQ(s.created, 3);
+  ASSERT_EQ(s.acquired, 1);
+  ASSERT_EQ(s.expired, 1);
+  ASSERT_EQ(s.deleted_not_acquired, 2);
+  ASSERT_EQ(s.live, 0);
+  ASSERT_EQ(s.live_high_water, 3);
+}
+
+TEST_F(owned_pointer_stats_ut, countsSeparateBlocksAndLinks)
+{
+  std::unique_ptr<int> u{new int{1}};
+  {
+    csp::owned_pointer<int> p = csp::make_owned<int>(1);
+    csp::owned_pointer<int> l = csp::link(u);
+    csp::owned_pointer<int> q = std::unique_ptr<int>{new int{2}};
+
+    auto v = q.unique_ptr();
+  }
+
+  const auto s = csp::lifecycle_stats_of<int>();
+
+  ASSERT_EQ(s.created, 3);
+  ASSERT_EQ(s.acquired, 1);
+  ASSERT_EQ(s.expired, 0);
+  ASSERT_EQ(s.deleted_not_acquired, 1);
+  ASSERT_EQ(s.live, 0);
+}
+
+TEST_F(owned_pointer_stats_ut, trackedObjectDeletedByItsBlockIsNotExpired)
+{
+  {
+    auto p = csp::make_owned<tracked_value>();
+    auto q = csp::make_owned<tracked_value>();
+
+    q.unique_ptr().reset();
+  }
+
+  const auto s = csp::lifecycle_stats_of<tracked_value>();
+
+  ASSERT_EQ(s.created, 2);
+  ASSERT_EQ(s.acquired, 1);
+  ASSERT_EQ(s.expired, 1);
+  ASSERT_EQ(s.deleted_not_acquired, 1);
+  ASSERT_EQ(s.live, 0);
+}
+
+TEST_F(owned_pointer_stats_ut, countsFromManyThreads)
+{
+  std::vector<std::thread> threads;
+
+  for(int i = 0; i < 8; i++)
+    threads.emplace_back([]{
+      for(int j = 0; j < 1000; j++)
+        csp::make_owned<other_class>().unique_ptr();
+    });
+
+  for(auto& t : threads) t.join();
+
+  const auto s = csp::lifecycle_stats_of<other_class>();
+
+  ASSERT_EQ(s.created, 8000);
+  ASSERT_EQ(s.acquired, 8000);
+  ASSERT_EQ(s.expired, 8000);
+  ASSERT_EQ(s.live, 0);
+  ASSERT_GE(s.live_high_water, 1);
+}
+
+TEST_F(owned_pointer_stats_ut, listenerPrintsUsedTypesAndResets)
+{
+  std::ostringstream out;
+  csp::lifecycle_stats_listener listener{out};
+  const auto p = csp::make_owned<other_class>();
+
+  listener.OnTestSuiteEnd(*UnitTest::GetInstance()->current_test_suite());
+  ASSERT_THAT(out.str(), HasSubstr(std::string{typeid(other_class).name()} + " created 1, acquired 0"));
+  ASSERT_THAT(out.str(), Not(HasSubstr(typeid(int).name() + std::string{" created"})));
+
+  listener.OnTestSuiteStart(*UnitTest::GetInstance()->current_test_suite());
+  ASSERT_EQ(csp::lifecycle_stats_of<other_class>().created, 0);
+  ASSERT_EQ(csp::lifecycle_stats_of<other_class>().live_high_water, 1);
+}
+
+TEST_F(owned_pointer_stats_ut, registryRecordsLiveObjects)
+{
+  const auto p = csp::make_owned<other_class>();
+  auto u = csp::make_owned<other_class>().unique_ptr();
+  const auto objects = csp::live_objects();
+
+  const auto found = std::count_if(objects.begin(), objects.end(), [&](const csp::live_object& o) {
+    return (o.address == p.get() && !o.acquired) || (o.address == u.get() && o.acquired);
+  });
+
+  ASSERT_EQ(found, 2);
+  ASSERT_TRUE(std::all_of(objects.begin(), objects.end(), [](const csp::live_object& o) {
+    return o.site == std::string{"owned_pointer_stats_ut.registryRecordsLiveObjects"};
+  }));
+}
+
+TEST_F(owned_pointer_stats_ut, registryReportsAcquiredAndNeverDeletedObjects)
+{
+  std::unique_ptr<simple_base_class> leaked;
+  std::unique_ptr<int> not_expired_enabled;
+  {
+    OWNED_POINTER_SITE();
+    leaked = csp::make_owned<simple_base_class>().unique_ptr();
+    not_expired_enabled = csp::make_owned<int>(1).unique_ptr();
+    csp::make_owned<simple_base_class>().unique_ptr();
+  }
+
+  const auto leaks = csp::leaked_objects(mark);
+
+  ASSERT_EQ(leaks.size(), 1u);
+  ASSERT_EQ(leaks[0].address, leaked.get());
+  ASSERT_THAT(leaks[0].site, HasSubstr("owned_pointer_stats_ut.cpp:"));
+  ASSERT_THAT(leaks[0].type_name, HasSubstr(typeid(simple_base_class).name()));
+
+  EXPECT_NONFATAL_FAILURE(leak_check.verify(), "was acquired by unique_ptr and never deleted");
+
+  leaked.reset();
+  ASSERT_TRUE(csp::leaked_objects(mark).empty());
+}
+
+TEST_F(owned_pointer_stats_ut, registryIsFilledFromManyThreads)
+{
+  std::vector<std::thread> threads;
+  std::vector<std::vector<csp::owned_pointer<other_class>>> objects(8);
+
+  for(auto& v : objects)
+    threads.emplace_back([&v]{
+      for(int j = 0; j < 1000; j++)
+        v.push_back(csp::make_owned<other_class>());
+      v.erase(v.begin(), v.begin() + 500);
+    });
+
+  for(auto& t : threads) t.join();
+
+  ASSERT_EQ(csp::live_objects().size(), 8 * 500u);
+}
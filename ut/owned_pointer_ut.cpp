@@ -28,6 +28,9 @@
 
 #include "owned_pointer.hpp"
 #include "gmock_macros_for_unique_ptr.hpp"
+#include "gmock_owned_actions.hpp"
+#include "gmock_owned_matchers.hpp"
+#include "owned_pointer_expiry.hpp"
 
 using namespace ::testing;
 
@@ -145,6 +148,28 @@ protected:
     MOCK_UNIQUE_METHOD1(create, std::unique_ptr<std::ostream>(const std::string&));
   };
 
+#ifdef MOCK_METHOD
+  struct wide_interface
+  {
+    virtual std::unique_ptr<simple_base_class> make(int, std::unique_ptr<simple_base_class>, int, int, int,
+                                                    int, int, int, int, int, int, int) const = 0;
+    virtual void take(std::unique_ptr<destruction_test_mock>) = 0;
+    virtual std::unique_ptr<simple_base_class> none() const = 0;
+    virtual std::pair<int, int> swap(std::pair<int, int>, std::unique_ptr<destruction_test_mock>) = 0;
+    virtual ~wide_interface() = default;
+  };
+
+  struct wide_mock : wide_interface
+  {
+    MOCK_UNIQUE_METHOD(std::unique_ptr<simple_base_class>, make, (int, std::unique_ptr<simple_base_class>, int, int, int,
+                                                                  int, int, int, int, int, int, int), (const, override));
+    MOCK_UNIQUE_METHOD(void, take, (std::unique_ptr<destruction_test_mock>), (override));
+    MOCK_UNIQUE_METHOD(std::unique_ptr<simple_base_class>, none, (), (const, override));
+    MOCK_UNIQUE_METHOD((std::pair<int, int>), swap, ((std::pair<int, int>), std::unique_ptr<destruction_test_mock>),
+                       (override));
+  };
+#endif
+
   struct Taker
   {
     virtual void giveme(std::ostream&) = 0;
@@ -154,6 +179,55 @@ protected:
   {
     MOCK_METHOD1(giveme, void(std::ostream&));
   };
+
+  template<typename T>
+  struct counting_allocator
+  {
+    using value_type = T;
+
+    counting_allocator(int& a, int& d) noexcept : allocations(&a), deallocations(&d) {}
+
+    template<typename U>
+    counting_allocator(const counting_allocator<U>& o) noexcept
+      : allocations(o.allocations), deallocations(o.deallocations) {}
+
+    T* allocate(std::size_t n) { return ++*allocations, std::allocator<T>().allocate(n); }
+    void deallocate(T* p, std::size_t n) { ++*deallocations, std::allocator<T>().deallocate(p, n); }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>& o) const noexcept { return allocations == o.allocations; }
+
+    template<typename U>
+    bool operator!=(const counting_allocator<U>& o) const noexcept { return !(*this == o); }
+
+    int* allocations;
+    int* deallocations;
+  };
+
+  struct pool_deleter
+  {
+    void operator()(int *const p) const { ++*released, delete p; }
+    int* released;
+  };
+
+  struct tracked_value final
+  {
+    OWNED_POINTER_TRACK_DELETE()
+    int value;
+  };
+
+#ifdef MOCK_METHOD
+  struct buffer_sink
+  {
+    virtual void write(std::unique_ptr<std::uint8_t[]>, std::size_t) = 0;
+    virtual ~buffer_sink() = default;
+  };
+
+  struct buffer_sink_mock : buffer_sink
+  {
+    MOCK_UNIQUE_METHOD(void, write, (std::unique_ptr<std::uint8_t[]>, std::size_t), (override));
+  };
+#endif
 };
 
 TEST_F(owned_pointer_ut, isUniqueAndPtrOwnedPointingSameAddress)
@@ -457,6 +531,44 @@ TEST_F(owned_pointer_ut, testIsNullAndNotNullMatchers)
   base.test(nullptr);
 }
 
+TEST_F(owned_pointer_ut, sameObjectAsMatcherComparesAddresses)
+{
+  mock_class m;
+  mock_interface& base = m;
+  auto p = csp::make_owned<test_mock>();
+  const auto other = csp::make_owned<test_mock>();
+
+  expect_object_will_be_deleted(p);
+  expect_object_will_be_deleted(other);
+  EXPECT_CALL(m, _test(csp::SameObjectAs(other))).Times(0);
+  EXPECT_CALL(m, _test(csp::SameObjectAs(p))).WillOnce(Return(0));
+  base.test(p.unique_ptr());
+
+  ASSERT_THAT(p, csp::SameObjectAs(p));
+  ASSERT_THAT(p, Not(csp::SameObjectAs(other)));
+  ASSERT_EQ(p.use_count(), 1);
+}
+
+TEST_F(owned_pointer_ut, stateMatchersDontThrowForDeletedObject)
+{
+  auto p = csp::make_owned<test_mock>(0x123);
+
+  ASSERT_THAT(p, Not(csp::IsExpired()));
+  ASSERT_THAT(p, Not(csp::IsAcquired()));
+  ASSERT_THAT(p, csp::PointsToOwned(Field(&destruction_test_mock::x, 0x123)));
+  ASSERT_THAT(p, Not(csp::PointsToOwned(Field(&destruction_test_mock::x, 1))));
+
+  auto u = p.unique_ptr();
+  ASSERT_THAT(p, csp::IsAcquired());
+
+  EXPECT_CALL(*u, die());
+  u.reset();
+
+  ASSERT_THAT(p, csp::IsExpired());
+  ASSERT_THAT(p, Not(csp::PointsToOwned(_)));
+  ASSERT_THAT(p, csp::SameObjectAs(p));
+}
+
 TEST_F(owned_pointer_ut, assertThatCompareOperatorsDontThrow)
 {
   auto p = csp::make_owned<test_mock>();
@@ -584,3 +696,897 @@ TEST_F(owned_pointer_ut, testCBeginEndAndSizePropagation)
   ASSERT_THAT(o.size(), ::testing::Eq(5));
   ASSERT_THAT(v, ::testing::ElementsAre(1,2,3,4,5));
 }
+
+TEST_F(owned_pointer_ut, objectSharesAllocationWithControlBlock)
+{
+  struct counted_new
+  {
+    static int& allocations() { static int n = 0; return n; }
+    static void* operator new(std::size_t n) { return ++allocations(), ::operator new(n); }
+    static void operator delete(void* p) { ::operator delete(p); }
+    virtual ~counted_new() = default;
+  };
+
+  auto p = csp::make_owned<counted_new>();
+  auto u = p.unique_ptr();
+
+  ASSERT_EQ(counted_new::allocations(), 0);
+  u.reset();
+
+  ASSERT_TRUE(p.expired());
+}
+
+TEST_F(owned_pointer_ut, acquiredObjectOutlivesAllOwnedPointers)
+{
+  std::unique_ptr<simple_base_class> u;
+  destruction_test_mock* raw;
+  {
+    auto p = csp::make_owned<test_mock>(0x123);
+    auto r = p;
+
+    raw = p.get();
+    u = p.unique_ptr();
+  }
+
+  Mock::VerifyAndClearExpectations(raw);
+
+  ASSERT_EQ(raw->x, 0x123);
+  EXPECT_CALL(*raw, die()).Times(1);
+  u.reset();
+}
+
+TEST_F(owned_pointer_ut, objectIsDeletedByOwnedPointerWhenUniquePtrIsMovedBack)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  csp::owned_pointer<destruction_test_mock> r{std::move(u)};
+
+  ASSERT_EQ(p, r);
+  ASSERT_FALSE(p.acquired());
+  expect_object_will_be_deleted(r);
+}
+
+TEST_F(owned_pointer_ut, allocateOwnedUsesAllocatorForObjectAndControlBlock)
+{
+  int allocations{}, deallocations{};
+  {
+    auto p = csp::allocate_owned<test_mock>(counting_allocator<char>{allocations, deallocations}, 0x123);
+    auto u = p.unique_ptr();
+
+    ASSERT_EQ(allocations, 1);
+    ASSERT_EQ(p->x, 0x123);
+    expect_object_will_be_deleted(p);
+  }
+  ASSERT_EQ(deallocations, 1);
+}
+
+TEST_F(owned_pointer_ut, allocateOwnedUsesAllocatorForControlBlockOfNonPolymorphicType)
+{
+  int allocations{}, deallocations{};
+  {
+    auto p = csp::allocate_owned<int>(counting_allocator<char>{allocations, deallocations}, 7);
+
+    ASSERT_EQ(allocations, 1);
+    ASSERT_EQ(*p, 7);
+  }
+  ASSERT_EQ(deallocations, 1);
+}
+
+#if OWNED_POINTER_HAS_PMR
+TEST_F(owned_pointer_ut, allocateOwnedFromMemoryResource)
+{
+  std::pmr::monotonic_buffer_resource resource;
+  auto p = csp::allocate_owned<test_mock>(&resource, 0x123);
+
+  ASSERT_EQ(p->x, 0x123);
+  expect_object_will_be_deleted(p);
+}
+#endif
+
+TEST_F(owned_pointer_ut, ownedScopeServesControlBlocks)
+{
+  csp::owned_scope scope;
+  ASSERT_EQ(csp::owned_scope::current(), &scope);
+
+  auto p = csp::make_owned<test_mock>();
+  auto r = csp::make_owned<int>(5);
+  csp::owned_pointer<int> l{std::unique_ptr<int>{new int{6}}};
+
+  auto u = p.unique_ptr();
+  expect_object_will_be_deleted(p);
+  u.reset();
+
+  ASSERT_TRUE(p.expired());
+  ASSERT_EQ(*r, 5);
+  ASSERT_EQ(*l, 6);
+}
+
+TEST_F(owned_pointer_ut, ownedScopeDestroysNeverAcquiredObjects)
+{
+  csp::owned_scope scope{128};
+
+  for(int i = 0; i < 100; i++)
+    expect_object_will_be_deleted(csp::make_owned<test_mock>(i));
+}
+
+TEST_F(owned_pointer_ut, nestedOwnedScopeRestoresOuterOne)
+{
+  static_assert(!std::is_move_constructible<csp::owned_scope>::value, "scope is bound to its place on stack");
+
+  csp::owned_scope outer;
+  {
+    csp::owned_scope inner;
+    ASSERT_EQ(csp::owned_scope::current(), &inner);
+  }
+
+  ASSERT_EQ(csp::owned_scope::current(), &outer);
+}
+
+TEST_F(owned_pointer_ut, controlBlocksCanOutliveOwnedScope)
+{
+  std::unique_ptr<destruction_test_mock> u;
+  csp::owned_pointer<destruction_test_mock> p;
+  {
+    csp::owned_scope scope;
+    p = csp::make_owned<test_mock>();
+    u = p.unique_ptr();
+  }
+
+  ASSERT_EQ(csp::owned_scope::current(), nullptr);
+  ASSERT_FALSE(p.expired());
+
+  expect_object_will_be_deleted(p);
+  u.reset();
+
+  ASSERT_TRUE(p.expired());
+}
+
+TEST_F(owned_pointer_ut, borrowChecksExpiryOnce)
+{
+  auto p = csp::make_owned<test_mock>(0x10);
+  auto u = p.unique_ptr();
+  {
+    const auto b = p.borrow();
+
+    for(int i = 0; i < 100; i++)
+      b->x++;
+
+    ASSERT_EQ(b.get(), p.get());
+    ASSERT_EQ((*b).x, 0x10 + 100);
+  }
+
+  expect_object_will_be_deleted(p);
+  u.reset();
+
+  ASSERT_THROW(p.borrow(), csp::ptr_is_already_deleted);
+  ASSERT_FALSE(csp::owned_pointer<int>{}.borrow());
+}
+
+TEST_F(owned_pointer_ut, sharedStateIsFoundThroughBaseAndForeignObjects)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  std::unique_ptr<simple_base_class> f{new destruction_test_mock};
+
+  for(int i = 0; i < 3; i++)
+  {
+    csp::owned_pointer<simple_base_class> b = csp::link<simple_base_class>(u);
+    csp::owned_pointer<simple_base_class> n = csp::link(f);
+
+    ASSERT_TRUE(is_expired_enabled_f(b));
+    ASSERT_FALSE(is_expired_enabled_f(n));
+    ASSERT_EQ(p.use_count(), 3);
+    ASSERT_EQ(n.use_count(), 1);
+  }
+
+  EXPECT_CALL(static_cast<destruction_test_mock&>(*f), die());
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(owned_pointer_ut, makeOwnedNCreatesContiguousObjects)
+{
+  auto v = csp::make_owned_n<test_mock>(10, 0x123);
+  const auto stride = reinterpret_cast<char*>(v[1].get()) - reinterpret_cast<char*>(v[0].get());
+
+  ASSERT_EQ(v.size(), 10u);
+  ASSERT_GE(stride, static_cast<std::ptrdiff_t>(sizeof(test_mock)));
+
+  for(std::size_t i = 1; i < v.size(); i++)
+  {
+    ASSERT_EQ(reinterpret_cast<char*>(v[i].get()) - reinterpret_cast<char*>(v[i - 1].get()), stride);
+    ASSERT_EQ(v[i]->x, 0x123);
+  }
+
+  for(auto& p : v)
+    expect_object_will_be_deleted(p);
+
+  auto u = v[3].unique_ptr();
+  u.reset();
+
+  ASSERT_TRUE(v[3].expired());
+  ASSERT_FALSE(v[4].expired());
+  ASSERT_FALSE(v[4].acquired());
+}
+
+TEST_F(owned_pointer_ut, makeOwnedNObjectsCanOutliveHandles)
+{
+  std::unique_ptr<destruction_test_mock> u;
+  {
+    auto v = csp::make_owned_n<test_mock>(4);
+    u = v[2].unique_ptr();
+
+    for(auto& p : v)
+      if(!p.acquired()) expect_object_will_be_deleted(p);
+  }
+
+  Mock::VerifyAndClearExpectations(u.get());
+  EXPECT_CALL(*u, die());
+}
+
+TEST_F(owned_pointer_ut, makeOwnedNForNonPolymorphicTypes)
+{
+  const auto v = csp::make_owned_n<int>(5, 7);
+
+  ASSERT_EQ(std::count_if(v.begin(), v.end(), [](const csp::owned_pointer<int>& p){ return *p == 7; }), 5);
+}
+
+TEST_F(owned_pointer_ut, makeOwnedGraphPlacesObjectsInOneRegion)
+{
+  auto g = csp::make_owned_graph<test_mock, simple_base_class, int>(std::make_tuple(5), std::make_tuple(), std::make_tuple(7));
+  auto& m = std::get<0>(g);
+  auto& b = std::get<1>(g);
+
+  const auto distance = reinterpret_cast<char*>(b.get()) - reinterpret_cast<char*>(m.get());
+  ASSERT_LT(std::abs(distance), 1024);
+  ASSERT_EQ(m->x, 5);
+  ASSERT_EQ(*std::get<2>(g), 7);
+
+  auto u = m.unique_ptr();
+  EXPECT_CALL(*u, die());
+  u.reset();
+
+  ASSERT_TRUE(m.expired());
+  ASSERT_FALSE(b.expired());
+  ASSERT_FALSE(b.acquired());
+}
+
+TEST_F(owned_pointer_ut, makeOwnedGraphObjectsCanOutliveHandles)
+{
+  std::unique_ptr<destruction_test_mock> u;
+  {
+    auto g = csp::make_owned_graph<test_mock, test_mock>();
+    u = std::get<1>(g).unique_ptr();
+    expect_object_will_be_deleted(std::get<0>(g));
+  }
+
+  Mock::VerifyAndClearExpectations(u.get());
+  EXPECT_CALL(*u, die());
+}
+
+TEST_F(owned_pointer_ut, rvalueUniquePtrHandsOverControlBlock)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto q = p;
+
+  auto u = std::move(q).unique_ptr();
+
+  ASSERT_FALSE(q);
+  ASSERT_TRUE(p.acquired());
+  ASSERT_EQ(p.use_count(), 2);
+  ASSERT_THROW(csp::owned_pointer<destruction_test_mock>{p}.unique_ptr(), csp::unique_ptr_already_acquired);
+
+  EXPECT_CALL(*u, die());
+  u.reset();
+
+  ASSERT_TRUE(p.expired());
+  ASSERT_EQ(p.use_count(), 1);
+
+  std::unique_ptr<destruction_test_mock> x{ csp::make_owned<test_mock>().unique_ptr() };
+  EXPECT_CALL(*x, die());
+}
+
+TEST_F(owned_pointer_ut, rvalueCastsMoveControlBlock)
+{
+  struct other_class : simple_base_class {};
+
+  auto p = csp::make_owned<test_mock>();
+  auto q = p;
+
+  csp::owned_pointer<simple_base_class> b = std::move(q);
+  ASSERT_FALSE(q);
+  ASSERT_EQ(p.use_count(), 2);
+
+  ASSERT_FALSE(csp::dynamic_pointer_cast<other_class>(std::move(b)));
+  ASSERT_TRUE(b);
+
+  auto d = csp::dynamic_pointer_cast<destruction_test_mock>(std::move(b));
+  ASSERT_FALSE(b);
+  ASSERT_EQ(d.get(), p.get());
+  ASSERT_EQ(p.use_count(), 2);
+
+  auto s = csp::static_pointer_cast<simple_base_class>(std::move(d));
+  ASSERT_FALSE(d);
+  ASSERT_EQ(s.get(), p.get());
+  ASSERT_EQ(p.use_count(), 2);
+
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(owned_pointer_ut, dynamicPointerCastKeepsAcquiredState)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  const csp::owned_pointer<simple_base_class> b = p;
+
+  const auto d = csp::dynamic_pointer_cast<destruction_test_mock>(b);
+
+  ASSERT_TRUE(d.acquired());
+  ASSERT_EQ(d.get(), u.get());
+  ASSERT_EQ(p.use_count(), 4);
+  EXPECT_CALL(*u, die());
+}
+
+#ifdef MOCK_METHOD
+TEST_F(owned_pointer_ut, variadicMockMethodSwapsUniquePtrs)
+{
+  wide_mock m;
+  wide_interface& base = m;
+  auto p = csp::make_owned<test_mock>();
+  auto r = csp::make_owned<test_mock>();
+
+  EXPECT_CALL(m, _make(1, Eq(p), _, _, _, _, _, _, _, _, _, 12)).WillOnce(Return(r));
+  EXPECT_CALL(m, _take(Eq(p)));
+
+  auto u = base.make(1, p.unique_ptr(), 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+  ASSERT_EQ(u.get(), r.get());
+  ASSERT_TRUE(r.acquired());
+
+  base.take(csp::owned_pointer<destruction_test_mock>{p}.unique_ptr());
+
+  expect_object_will_be_deleted(p);
+  expect_object_will_be_deleted(r);
+}
+#endif
+
+#ifdef MOCK_METHOD
+TEST_F(owned_pointer_ut, variadicMockMethodTakesNoArgumentsAndParenthesizedTypes)
+{
+  wide_mock m;
+  wide_interface& base = m;
+
+  EXPECT_CALL(m, _none()).WillOnce(Return(nullptr));
+  EXPECT_CALL(m, _swap(std::make_pair(1, 2), IsNull())).WillOnce(Return(std::make_pair(2, 1)));
+
+  ASSERT_EQ(base.none(), nullptr);
+  ASSERT_EQ(base.swap(std::make_pair(1, 2), nullptr), std::make_pair(2, 1));
+}
+#endif
+
+TEST_F(owned_pointer_ut, arrayIsHandedOutWithoutCopy)
+{
+  auto p = csp::make_owned<std::uint8_t[]>(16);
+  p[3] = 42;
+
+  const std::unique_ptr<std::uint8_t[]> u = p.unique_ptr();
+
+  ASSERT_EQ(u.get(), p.get());
+  ASSERT_EQ(u[3], 42);
+  ASSERT_EQ(u[0], 0);
+  ASSERT_TRUE(p == u);
+  ASSERT_THROW(p.unique_ptr(), csp::unique_ptr_already_acquired);
+}
+
+#ifdef MOCK_METHOD
+TEST_F(owned_pointer_ut, arrayInjectedIntoMockIsSameBuffer)
+{
+  buffer_sink_mock m;
+  buffer_sink& base = m;
+  csp::owned_pointer<std::uint8_t[]> buffer{ std::unique_ptr<std::uint8_t[]>{ new std::uint8_t[8]() } };
+
+  EXPECT_CALL(m, _write(Eq(buffer), 8));
+
+  base.write(buffer.unique_ptr(), 8);
+  ASSERT_TRUE(buffer.acquired());
+}
+#endif
+
+TEST_F(owned_pointer_ut, deleterIsStoredInControlBlock)
+{
+  int released = 0;
+  csp::owned_pointer<int, pool_deleter> p{ std::unique_ptr<int, pool_deleter>{ new int{5}, pool_deleter{&released} } };
+  const auto copy = p;
+
+  auto u = std::move(p).unique_ptr();
+
+  ASSERT_EQ(u.get(), copy.get());
+  ASSERT_EQ(u.get_deleter().released, &released);
+  ASSERT_THROW(copy.unique_ptr(), csp::unique_ptr_already_acquired);
+
+  u.reset();
+  ASSERT_EQ(released, 1);
+}
+
+TEST_F(owned_pointer_ut, neverAcquiredObjectIsReleasedWithStoredDeleter)
+{
+  int released = 0;
+  {
+    csp::owned_pointer<int, pool_deleter> p{ std::unique_ptr<int, pool_deleter>{ new int{5}, pool_deleter{&released} } };
+    ASSERT_EQ(*p, 5);
+  }
+  ASSERT_EQ(released, 1);
+
+  auto u = csp::owned_pointer<int, pool_deleter>{
+    std::unique_ptr<int, pool_deleter>{ new int{6}, pool_deleter{&released} } }.unique_ptr();
+  ASSERT_EQ(released, 1);
+  ASSERT_EQ(*u, 6);
+}
+
+TEST_F(owned_pointer_ut, sharedPtrAliasesControlBlock)
+{
+  std::shared_ptr<test_mock> s;
+  {
+    auto p = csp::make_owned<test_mock>();
+    s = p.shared_ptr();
+    const std::shared_ptr<simple_base_class> b = p.shared_ptr();
+
+    ASSERT_EQ(s.get(), p.get());
+    ASSERT_EQ(p.use_count(), 3);
+    ASSERT_TRUE(p.acquired());
+    ASSERT_FALSE(p.expired());
+    ASSERT_THROW(p.unique_ptr(), csp::unique_ptr_already_acquired);
+  }
+  EXPECT_CALL(*s, die());
+  s.reset();
+}
+
+TEST_F(owned_pointer_ut, sharedPtrIsNotGivenForAcquiredObject)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+
+  ASSERT_THROW(p.shared_ptr(), csp::unique_ptr_already_acquired);
+  ASSERT_EQ(csp::owned_pointer<test_mock>{}.shared_ptr(), nullptr);
+
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(owned_pointer_ut, sharedObjectIsDeletedByLastOwnedPointer)
+{
+  auto p = csp::make_owned<test_mock>();
+  p.shared_ptr().reset();
+
+  ASSERT_EQ(p.use_count(), 1);
+  expect_object_will_be_deleted(p);
+}
+
+TEST_F(owned_pointer_ut, deletionOfFinalValueTypeIsTracked)
+{
+  static_assert(sizeof(tracked_value) == sizeof(int), "hook must not change layout");
+  ASSERT_TRUE(csp::is_expired_enabled<csp::owned_pointer<tracked_value>>::value);
+  ASSERT_TRUE(csp::is_expired_enabled<csp::owned_pointer<const tracked_value>>::value);
+
+  auto p = csp::make_owned<tracked_value>(tracked_value{7});
+  const csp::owned_pointer<const tracked_value> c = p;
+  auto u = p.unique_ptr();
+
+  ASSERT_TRUE(is_expired_enabled_f(p));
+  ASSERT_FALSE(p.expired());
+  ASSERT_EQ(p->value, 7);
+
+  u.reset();
+
+  ASSERT_TRUE(p.expired());
+  ASSERT_TRUE(c.expired());
+  ASSERT_THROW(p.get(), csp::ptr_is_already_deleted);
+}
+
+TEST_F(owned_pointer_ut, linkedPointersToTrackedObjectExpireTogether)
+{
+  std::unique_ptr<tracked_value> u{ new tracked_value{1} };
+  const csp::owned_pointer<tracked_value> a{csp::link(u)};
+  const csp::owned_pointer<tracked_value> b{csp::link(u)};
+
+  u.reset();
+
+  ASSERT_TRUE(a.expired());
+  ASSERT_TRUE(b.expired());
+}
+
+#ifdef MOCK_METHOD
+TEST_F(owned_pointer_ut, mockArgumentsReuseControlBlocks)
+{
+  wide_mock m;
+  wide_interface& base = m;
+  std::vector<const void*> blocks;
+  csp::owned_pointer<destruction_test_mock> kept;
+
+  EXPECT_CALL(m, _take(_)).Times(2)
+    .WillRepeatedly(Invoke([&](csp::owned_pointer<destruction_test_mock> p) {
+      blocks.push_back(csp::_priv::owned_access::block(p));
+      EXPECT_CALL(*p, die());
+    }));
+
+  base.take(std::unique_ptr<destruction_test_mock>{ new destruction_test_mock });
+  base.take(std::unique_ptr<destruction_test_mock>{ new destruction_test_mock });
+
+  ASSERT_EQ(blocks[0], blocks[1]);
+
+  EXPECT_CALL(m, _take(_)).WillOnce(SaveArg<0>(&kept));
+  base.take(std::unique_ptr<destruction_test_mock>{ new destruction_test_mock });
+
+  ASSERT_EQ(csp::_priv::owned_access::block(kept), blocks[0]);
+  ASSERT_FALSE(kept.acquired());
+  expect_object_will_be_deleted(kept);
+}
+#endif
+
+TEST_F(owned_pointer_ut, returnOwnedFromRecordsHandedOutObjects)
+{
+  OStreamFactoryMock f;
+  OStreamFactory& base = f;
+  const csp::owned_factory<std::stringstream> streams;
+
+  EXPECT_CALL(f, _create(_)).WillRepeatedly(csp::ReturnOwnedFrom(streams));
+
+  auto kept = base.create("a");
+  for(int i = 0; i < 3; i++)
+    *base.create("b") << i;
+
+  const auto objects = streams.handed_out();
+  ASSERT_EQ(streams.size(), 4u);
+  ASSERT_TRUE(objects[0] == kept);
+  ASSERT_FALSE(objects[0].expired());
+
+  for(std::size_t i = 1; i < objects.size(); i++)
+    ASSERT_TRUE(objects[i].expired() && objects[i].acquired());
+}
+
+#ifdef MOCK_METHOD
+TEST_F(owned_pointer_ut, returnOwnedCreatesObjectPerCall)
+{
+  wide_mock m;
+  wide_interface& base = m;
+
+  EXPECT_CALL(m, _make(_, _, _, _, _, _, _, _, _, _, _, _)).Times(2).WillRepeatedly(csp::ReturnOwned<destruction_test_mock>(5));
+
+  const auto a = base.make(1, nullptr, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+  const auto b = base.make(1, nullptr, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+
+  ASSERT_NE(a.get(), b.get());
+  EXPECT_CALL(*static_cast<destruction_test_mock*>(a.get()), die());
+  EXPECT_CALL(*static_cast<destruction_test_mock*>(b.get()), die());
+  ASSERT_EQ(static_cast<destruction_test_mock*>(a.get())->x, 5);
+}
+#endif
+
+TEST_F(owned_pointer_ut, onExpiredCallbacksRunWhenObjectIsDeleted)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  int calls = 0;
+
+  csp::on_expired(p, [&]{ calls++; });
+  csp::on_expired(p, [&]{ calls += 10; });
+  EXPECT_CALL(*u, die());
+  u.reset();
+
+  ASSERT_EQ(calls, 11);
+
+  csp::on_expired(p, [&]{ calls++; });
+  ASSERT_EQ(calls, 12);
+}
+
+namespace
+{
+struct flagged_base
+{
+  explicit flagged_base(bool& d) : destroyed(d) {}
+  virtual ~flagged_base() { destroyed = true; }
+  bool& destroyed;
+};
+
+struct flagged_derived : flagged_base
+{
+  using flagged_base::flagged_base;
+};
+}
+
+TEST_F(owned_pointer_ut, onExpiredRunsAfterWholeDestructor)
+{
+  bool destroyed = false;
+  bool seen = false;
+  auto p = csp::make_owned<flagged_derived>(destroyed);
+  auto u = p.unique_ptr();
+
+  csp::on_expired(p, [&]{ seen = destroyed; });
+  u.reset();
+
+  ASSERT_TRUE(seen);
+}
+
+TEST_F(owned_pointer_ut, expiryFutureOfTrackedValueType)
+{
+  auto p = csp::make_owned<tracked_value>();
+  auto f = csp::expiry_future(p);
+  auto u = p.unique_ptr();
+
+  ASSERT_EQ(f.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+  u.reset();
+  ASSERT_EQ(f.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+}
+
+TEST_F(owned_pointer_ut, expiryFutureIsBrokenWhenBlockDiesFirst)
+{
+  auto f = csp::expiry_future(csp::make_owned<simple_base_class>());
+  ASSERT_THROW(f.get(), std::future_error);
+
+  int calls = 0;
+  csp::on_expired(csp::make_owned<simple_base_class>(), [&]{ calls++; });
+  ASSERT_EQ(calls, 0);
+}
+
+#if OWNED_POINTER_HAS_COROUTINES
+namespace
+{
+struct detached_task
+{
+  struct promise_type
+  {
+    auto get_return_object() noexcept -> detached_task { return {}; }
+    auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template<typename T>
+auto wait_for_deletion(csp::owned_pointer<T> p, bool& resumed) -> detached_task
+{
+  co_await csp::until_expired(std::move(p));
+  resumed = true;
+}
+}
+
+TEST_F(owned_pointer_ut, coroutineIsResumedByDeletion)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  bool resumed = false;
+
+  wait_for_deletion(p, resumed);
+  ASSERT_FALSE(resumed);
+
+  EXPECT_CALL(*u, die());
+  u.reset();
+  ASSERT_TRUE(resumed);
+}
+
+namespace
+{
+struct suspended_task
+{
+  struct promise_type
+  {
+    auto get_return_object() noexcept -> suspended_task
+    {
+      return {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_always { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+auto wait_in_task(csp::owned_pointer<T> p, bool& resumed) -> suspended_task
+{
+  co_await csp::until_expired(std::move(p));
+  resumed = true;
+}
+}
+
+TEST_F(owned_pointer_ut, destroyedCoroutineIsNotResumed)
+{
+  auto p = csp::make_owned<test_mock>();
+  auto u = p.unique_ptr();
+  bool resumed = false;
+
+  wait_in_task(p, resumed).handle.destroy();
+
+  EXPECT_CALL(*u, die());
+  u.reset();
+  ASSERT_FALSE(resumed);
+}
+#endif
+
+namespace
+{
+struct counted_class
+{
+  counted_class(int& count, const int v) : value{v} { count++; }
+  virtual ~counted_class() = default;
+
+  int value;
+};
+}
+
+TEST_F(owned_pointer_ut, makeOwnedLazyConstructsObjectOnFirstAccess)
+{
+  int constructed = 0;
+  auto p = csp::make_owned_lazy<counted_class>(std::ref(constructed), 5);
+  auto r = p;
+
+  ASSERT_EQ(constructed, 0);
+  ASSERT_TRUE(p);
+  ASSERT_TRUE(p == r);
+  ASSERT_FALSE(p.expired());
+  ASSERT_FALSE(p.acquired());
+
+  ASSERT_EQ(r->value, 5);
+  ASSERT_EQ(p.get()->value, 5);
+  ASSERT_EQ(constructed, 1);
+}
+
+TEST_F(owned_pointer_ut, lazyObjectWhichIsNeverUsedIsNeverConstructed)
+{
+  int constructed = 0;
+  {
+    auto p = csp::make_owned_lazy<counted_class>(std::ref(constructed), 5);
+    csp::owned_pointer<counted_class> r = p;
+  }
+
+  ASSERT_EQ(constructed, 0);
+}
+
+TEST_F(owned_pointer_ut, matchersDontConstructLazyObject)
+{
+  int constructed = 0;
+  auto p = csp::make_owned_lazy<counted_class>(std::ref(constructed), 5);
+  const ::testing::Matcher<csp::owned_pointer<counted_class>> m = csp::PointsToOwned(Field(&counted_class::value, 5));
+
+  ASSERT_FALSE(m.Matches(p));
+  ASSERT_THAT(p, Not(csp::PointsToOwned(_)));
+  ASSERT_THAT(p, Not(csp::IsExpired()));
+  ASSERT_EQ(constructed, 0);
+
+  ASSERT_EQ(p->value, 5);
+  ASSERT_TRUE(m.Matches(p));
+  ASSERT_EQ(p.use_count(), 1);
+}
+
+TEST_F(owned_pointer_ut, lazyObjectAcquiredByUniquePtrExpires)
+{
+  auto p = csp::make_owned_lazy<test_mock>(7);
+  auto u = p.unique_ptr();
+
+  ASSERT_TRUE(p.acquired());
+  ASSERT_EQ(u->x, 7);
+  ASSERT_TRUE(csp::is_expired_enabled_f(p));
+  assert_that_get_unique_throws(p);
+
+  EXPECT_CALL(*u, die());
+  u.reset();
+  assert_that_operators_throw(p);
+}
+
+TEST_F(owned_pointer_ut, lazyObjectNotAcquiredIsDeletedWithBlock)
+{
+  auto p = csp::make_owned_lazy<test_mock>();
+
+  EXPECT_CALL(*p, die());
+  p = nullptr;
+}
+
+TEST_F(owned_pointer_ut, embeddedObjectCostsOneWord)
+{
+  ASSERT_EQ(sizeof(csp::_priv::embedded_object<simple_base_class>), sizeof(simple_base_class) + sizeof(void*));
+}
+
+TEST_F(owned_pointer_ut, setListenerAndLazyStateAreOutOfControlBlock)
+{
+  // object, state flags, keep_alive and one pointer to extras
+  ASSERT_LE(sizeof(csp::_priv::control_block_type), 3 * sizeof(void*) + sizeof(std::shared_ptr<int>));
+}
+
+TEST_F(owned_pointer_ut, uniquePtrOfEmbeddedObjectIsMovedBackToItsBlock)
+{
+  auto p = csp::make_owned<test_mock>();
+  std::unique_ptr<simple_base_class> u = p.unique_ptr();
+  csp::owned_pointer<simple_base_class> r{std::move(u)};
+
+  ASSERT_EQ(csp::_priv::owned_access::block(r), csp::_priv::owned_access::block(p));
+  ASSERT_FALSE(p.acquired());
+
+  EXPECT_CALL(*p, die());
+  r.unique_ptr().reset();
+  ASSERT_TRUE(p.expired());
+}
+
+TEST_F(owned_pointer_ut, dynamicPointerCastIsRememberedPerDynamicType)
+{
+  struct other_class : simple_base_class {};
+
+  const csp::owned_pointer<simple_base_class> a = csp::make_owned<test_mock>();
+  const csp::owned_pointer<simple_base_class> b = csp::make_owned<other_class>();
+
+  for(int i = 0; i < 3; i++)
+  {
+    ASSERT_TRUE(csp::dynamic_pointer_cast<destruction_test_mock>(a));
+    ASSERT_FALSE(csp::dynamic_pointer_cast<destruction_test_mock>(b));
+    ASSERT_EQ(a.use_count(), 1);
+    ASSERT_EQ(b.use_count(), 1);
+  }
+
+  EXPECT_CALL(*csp::dynamic_pointer_cast<test_mock>(a), die());
+}
+
+TEST_F(owned_pointer_ut, dynamicPointerCastMovingAddressIsRefused)
+{
+  struct other_interface
+  {
+    virtual ~other_interface() = default;
+    int y = 0;
+  };
+  struct both_class : simple_base_class, other_interface {};
+
+  const csp::owned_pointer<simple_base_class> p = csp::make_owned<both_class>();
+
+  ASSERT_TRUE(csp::dynamic_pointer_cast<both_class>(p));
+  ASSERT_FALSE(csp::dynamic_pointer_cast<other_interface>(p));
+  ASSERT_FALSE(csp::dynamic_pointer_cast<other_interface>(csp::owned_pointer<simple_base_class>{}));
+}
+
+namespace
+{
+struct final_class final
+{
+  explicit final_class(int v) : value{v} {}
+  virtual ~final_class() = default;
+
+  int value;
+};
+
+struct final_consumer
+{
+  virtual int consume(std::unique_ptr<final_class>) = 0;
+  virtual ~final_consumer() = default;
+};
+
+struct final_consumer_mock : final_consumer
+{
+  MOCK_UNIQUE_METHOD1(consume, int(std::unique_ptr<final_class>));
+};
+}
+
+TEST_F(owned_pointer_ut, uniquePtrOfFinalPolymorphicTypeGetsSeparateBlock)
+{
+  csp::owned_pointer<final_class> p{std::unique_ptr<final_class>{new final_class{1}}};
+  ASSERT_EQ(p->value, 1);
+
+  final_consumer_mock m;
+  final_consumer& base = m;
+  EXPECT_CALL(m, _consume(_)).WillOnce(Invoke([](csp::owned_pointer<final_class> a){ return a->value; }));
+
+  ASSERT_EQ(base.consume(p.unique_ptr()), 1);
+}
+
+namespace
+{
+struct polymorphic_without_virtual_dtor
+{
+  virtual int f() { return 2; }
+};
+}
+
+TEST_F(owned_pointer_ut, uniquePtrOfTypeWithoutVirtualDtorGetsSeparateBlock)
+{
+  csp::owned_pointer<polymorphic_without_virtual_dtor> p{
+    std::unique_ptr<polymorphic_without_virtual_dtor>{new polymorphic_without_virtual_dtor}};
+
+  ASSERT_EQ(p->f(), 2);
+  ASSERT_FALSE(csp::is_expired_enabled_f(p));
+}